@@ -29,6 +29,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 
 namespace astyle
@@ -39,6 +40,9 @@ namespace astyle
    */
   ASBeautifier::ASBeautifier()
   {
+    stackArena = new ASStackArena;
+    isStackArenaOwner = true;
+    commaScanIndex = -1;
     waitingBeautifierStack = nullptr;
     activeBeautifierStack = nullptr;
     waitingBeautifierStackLengthStack = nullptr;
@@ -73,13 +77,20 @@ namespace astyle
     setPreprocessorIndent(false);
 
     // initialize ASBeautifier member vectors
+    // the language vectors are set by initVectors()
     beautifierFileType = 9;    // reset to an invalid type
-    headers                = new std::vector<const std::string*>;
-    nonParenHeaders        = new std::vector<const std::string*>;
+
+    for(std::int32_t i = 0; i <= SHARP_TYPE; i++)
+    {
+      beautifierVectors[i] = nullptr;
+    }
+
+    headers                = nullptr;
+    nonParenHeaders        = nullptr;
+    preBlockStatements     = nullptr;
+    preCommandHeaders      = nullptr;
     assignmentOperators    = new std::vector<const std::string*>;
     nonAssignmentOperators = new std::vector<const std::string*>;
-    preBlockStatements     = new std::vector<const std::string*>;
-    preCommandHeaders      = new std::vector<const std::string*>;
     indentableHeaders      = new std::vector<const std::string*>;
   }
 
@@ -94,6 +105,11 @@ namespace astyle
     // the std::vector objects in the copied std::vector.
     // This is the reason a copy constructor is needed.
 
+    // the clone uses the stack arena of the original beautifier
+    stackArena = other.stackArena;
+    isStackArenaOwner = false;
+    commaScanIndex = -1;
+
     // these don't need to copy the stack
     waitingBeautifierStack = nullptr;
     activeBeautifierStack = nullptr;
@@ -102,36 +118,42 @@ namespace astyle
 
     // std::vector '=' operator performs a DEEP copy of all elements in the std::vector
 
-    headerStack  = new std::vector<const std::string*>;
+    headerStack  = stackArena->newStack<ASStack<const std::string*> >();
     *headerStack = *other.headerStack;
 
     tempStacks = copyTempStacks(other);
 
-    blockParenDepthStack = new std::vector<std::int32_t>;
+    blockParenDepthStack = stackArena->newStack<ASStack<std::int32_t> >();
     *blockParenDepthStack = *other.blockParenDepthStack;
 
-    blockStatementStack = new std::vector<bool>;
+    blockStatementStack = stackArena->newStack<ASStack<bool> >();
     *blockStatementStack = *other.blockStatementStack;
 
-    parenStatementStack =  new std::vector<bool>;
+    parenStatementStack =  stackArena->newStack<ASStack<bool> >();
     *parenStatementStack = *other.parenStatementStack;
 
-    bracketBlockStateStack = new std::vector<bool>;
+    bracketBlockStateStack = stackArena->newStack<ASStack<bool> >();
     *bracketBlockStateStack = *other.bracketBlockStateStack;
 
-    inStatementIndentStack = new std::vector<std::int32_t>;
+    inStatementIndentStack = stackArena->newStack<ASStack<std::int32_t> >();
     *inStatementIndentStack = *other.inStatementIndentStack;
 
-    inStatementIndentStackSizeStack = new std::vector<std::int32_t>;
+    inStatementIndentStackSizeStack = stackArena->newStack<ASStack<std::int32_t> >();
     *inStatementIndentStackSizeStack = *other.inStatementIndentStackSizeStack;
 
-    parenIndentStack = new std::vector<std::int32_t>;
+    parenIndentStack = stackArena->newStack<ASStack<std::int32_t> >();
     *parenIndentStack = *other.parenIndentStack;
 
     // Copy the pointers to vectors.
     // This is ok because the original ASBeautifier object
     // is not deleted until end of job.
     beautifierFileType = other.beautifierFileType;
+
+    for(std::int32_t i = 0; i <= SHARP_TYPE; i++)
+    {
+      beautifierVectors[i] = nullptr;    // owned by the original beautifier
+    }
+
     headers = other.headers;
     nonParenHeaders = other.nonParenHeaders;
     assignmentOperators = other.assignmentOperators;
@@ -230,19 +252,12 @@ namespace astyle
    */
   ASBeautifier::~ASBeautifier()
   {
-    deleteContainer(waitingBeautifierStack);
-    deleteContainer(activeBeautifierStack);
-    deleteContainer(waitingBeautifierStackLengthStack);
-    deleteContainer(activeBeautifierStackLengthStack);
-    deleteContainer(headerStack);
-    deleteContainer(tempStacks);
-    deleteContainer(blockParenDepthStack);
-    deleteContainer(blockStatementStack);
-    deleteContainer(parenStatementStack);
-    deleteContainer(bracketBlockStateStack);
-    deleteContainer(inStatementIndentStack);
-    deleteContainer(inStatementIndentStackSizeStack);
-    deleteContainer(parenIndentStack);
+    deleteBeautifierContainers();
+
+    if(isStackArenaOwner)
+    {
+      delete stackArena;
+    }
   }
 
   /**
@@ -269,28 +284,29 @@ namespace astyle
     initVectors();
     ASBase::init(getFileType());
 
-    initContainer(waitingBeautifierStack, new std::vector<ASBeautifier*>);
-    initContainer(activeBeautifierStack, new std::vector<ASBeautifier*>);
+    // the stacks of the previous file are cleared, not reallocated
+    initContainer(waitingBeautifierStack);
+    initContainer(activeBeautifierStack);
 
-    initContainer(waitingBeautifierStackLengthStack, new std::vector<std::int32_t>);
-    initContainer(activeBeautifierStackLengthStack, new std::vector<std::int32_t>);
+    initContainer(waitingBeautifierStackLengthStack);
+    initContainer(activeBeautifierStackLengthStack);
 
-    initContainer(headerStack,  new std::vector<const std::string*>);
+    initContainer(headerStack);
 
-    initContainer(tempStacks, new std::vector<std::vector<const std::string*>*>);
-    tempStacks->push_back(new std::vector<const std::string*>);
+    initContainer(tempStacks);
+    tempStacks->push_back(stackArena->newStack<ASStack<const std::string*> >());
 
-    initContainer(blockParenDepthStack, new std::vector<std::int32_t>);
-    initContainer(blockStatementStack, new std::vector<bool>);
-    initContainer(parenStatementStack, new std::vector<bool>);
+    initContainer(blockParenDepthStack);
+    initContainer(blockStatementStack);
+    initContainer(parenStatementStack);
 
-    initContainer(bracketBlockStateStack, new std::vector<bool>);
+    initContainer(bracketBlockStateStack);
     bracketBlockStateStack->push_back(true);
 
-    initContainer(inStatementIndentStack, new std::vector<std::int32_t>);
-    initContainer(inStatementIndentStackSizeStack, new std::vector<std::int32_t>);
+    initContainer(inStatementIndentStack);
+    initContainer(inStatementIndentStackSizeStack);
     inStatementIndentStackSizeStack->push_back(0);
-    initContainer(parenIndentStack, new std::vector<std::int32_t>);
+    initContainer(parenIndentStack);
 
     previousLastLineHeader = nullptr;
     currentHeader = nullptr;
@@ -366,21 +382,37 @@ namespace astyle
 
     beautifierFileType = fileType;
 
-    headers->clear();
-    nonParenHeaders->clear();
-    assignmentOperators->clear();
-    nonAssignmentOperators->clear();
-    preBlockStatements->clear();
-    preCommandHeaders->clear();
-    indentableHeaders->clear();
+    // the vectors for a file type are built only once
+    // and reused when another file of the same type is formatted
+    if(beautifierVectors[fileType] == nullptr)
+    {
+      beautifierVectors[fileType] = new BeautifierVectors;
+      ASResource::buildHeaders(&beautifierVectors[fileType]->headers, fileType, true);
+      ASResource::buildNonParenHeaders(&beautifierVectors[fileType]->nonParenHeaders, fileType, true);
+      ASResource::buildPreBlockStatements(&beautifierVectors[fileType]->preBlockStatements, fileType);
+      ASResource::buildPreCommandHeaders(&beautifierVectors[fileType]->preCommandHeaders, fileType);
+    }
+
+    headers = &beautifierVectors[fileType]->headers;
+    nonParenHeaders = &beautifierVectors[fileType]->nonParenHeaders;
+    preBlockStatements = &beautifierVectors[fileType]->preBlockStatements;
+    preCommandHeaders = &beautifierVectors[fileType]->preCommandHeaders;
+
+    // these do not depend on the file type
+    if(assignmentOperators->size() == 0)
+    {
+      ASResource::buildAssignmentOperators(assignmentOperators);
+    }
+
+    if(nonAssignmentOperators->size() == 0)
+    {
+      ASResource::buildNonAssignmentOperators(nonAssignmentOperators);
+    }
 
-    ASResource::buildHeaders(headers, fileType, true);
-    ASResource::buildNonParenHeaders(nonParenHeaders, fileType, true);
-    ASResource::buildAssignmentOperators(assignmentOperators);
-    ASResource::buildNonAssignmentOperators(nonAssignmentOperators);
-    ASResource::buildPreBlockStatements(preBlockStatements, fileType);
-    ASResource::buildPreCommandHeaders(preCommandHeaders, fileType);
-    ASResource::buildIndentableHeaders(indentableHeaders);
+    if(indentableHeaders->size() == 0)
+    {
+      ASResource::buildIndentableHeaders(indentableHeaders);
+    }
   }
 
   /**
@@ -719,7 +751,23 @@ namespace astyle
    */
   std::string ASBeautifier::beautify(const std::string& originalLine)
   {
-    std::string line;
+    std::string beautifiedLine;
+    beautify(originalLine, beautifiedLine);
+    return beautifiedLine;
+  }
+
+  /**
+   * beautify a line of source code and append the indented line
+   * to a buffer owned by the caller.
+   * the buffer and the beautifier's line buffer keep their capacity,
+   * so no memory is allocated once they are large enough.
+   *
+   * @param originalLine       the original unindented line.
+   * @param outBuffer          the buffer the indented line is appended to.
+   */
+  void ASBeautifier::beautify(const std::string& originalLine, std::string& outBuffer)
+  {
+    std::string& line = lineBuffer;
     bool lineStartsInComment = false;
     bool isInQuoteContinuation = isInVerbatimQuote | haveLineContinuationChar;
     std::size_t iPrelim;
@@ -745,6 +793,8 @@ namespace astyle
     // If not in comment, first find out size of white space before line,
     // so that possible comments starting in the line continue in
     // relation to the preliminary white-space.
+    line.clear();
+
     if(isInQuoteContinuation)
     {
       // trim a single space added by ASFormatter, otherwise leave it alone
@@ -775,7 +825,14 @@ namespace astyle
     }
     else
     {
-      line = trim(originalLine);
+      // trim without creating a temporary string
+      std::size_t trimStart = originalLine.find_first_not_of(" \t");
+
+      if(trimStart != std::string::npos)
+      {
+        std::size_t trimEnd = originalLine.find_last_not_of(" \t");
+        line.assign(originalLine, trimStart, trimEnd + 1 - trimStart);
+      }
 
       if(line.length() > 0 && line[0] == '{')
       {
@@ -806,11 +863,12 @@ namespace astyle
       else if(emptyLineFill && !isInQuoteContinuation
               && (headerStack->size() > 0 || isInEnum))
       {
-        return preLineWS(prevFinalLineSpaceTabCount, prevFinalLineTabCount);
+        preLineWS(outBuffer, prevFinalLineSpaceTabCount, prevFinalLineTabCount);
+        return;
       }
       else
       {
-        return line;
+        return;
       }
     }
 
@@ -837,22 +895,22 @@ namespace astyle
       // and then remove it from the active beautifier stack and delete it.
       if(!backslashEndsPrevLine && isInDefineDefinition && !isInDefine)
       {
-        std::string beautifiedLine;
         ASBeautifier* defineBeautifier;
 
         isInDefineDefinition = false;
         defineBeautifier = activeBeautifierStack->back();
         activeBeautifierStack->pop_back();
 
-        beautifiedLine = defineBeautifier->beautify(line);
+        defineBeautifier->beautify(line, outBuffer);
         delete defineBeautifier;
-        return beautifiedLine;
+        return;
       }
 
       // unless this is a multi-line #define, return this precompiler line as is.
       if(!isInDefine && !isInDefineDefinition)
       {
-        return originalLine;
+        outBuffer.append(originalLine);
+        return;
       }
     }
 
@@ -872,7 +930,8 @@ namespace astyle
       activeBeautifierStack->back()->isInBeautifySQL = isInBeautifySQL;
       activeBeautifierStack->back()->isInIndentableStruct = isInIndentableStruct;
       // must return originalLine not the trimmed line
-      return activeBeautifierStack->back()->beautify(originalLine);
+      activeBeautifierStack->back()->beautify(originalLine, outBuffer);
+      return;
     }
 
     // calculate preliminary indentation based on data from past lines
@@ -1107,7 +1166,8 @@ namespace astyle
       spaceTabCount = spaceTabCount % indentLength;
     }
 
-    std::string outBuffer = preLineWS(spaceTabCount, tabCount) + line;
+    preLineWS(outBuffer, spaceTabCount, tabCount);
+    outBuffer.append(line);
 
     prevFinalLineSpaceTabCount = spaceTabCount;
     prevFinalLineTabCount = tabCount;
@@ -1116,27 +1176,20 @@ namespace astyle
     {
       previousLastLineHeader = lastLineHeader;
     }
-
-    return outBuffer;
   }
 
 
-  std::string ASBeautifier::preLineWS(std::int32_t spaceTabCount_, std::int32_t tabCount_)
+  void ASBeautifier::preLineWS(std::string& outBuffer, std::int32_t spaceTabCount_, std::int32_t tabCount_) const
   {
-    std::string ws;
-
     for(std::int32_t i = 0; i < tabCount_; i++)
     {
-      ws += indentString;
+      outBuffer.append(indentString);
     }
 
-    while((spaceTabCount_--) > 0)
+    if(spaceTabCount_ > 0)
     {
-      ws += std::string(" ");
+      outBuffer.append(spaceTabCount_, ' ');
     }
-
-    return ws;
-
   }
 
   bool ASBeautifier::isClassAccessModifier(const std::string& line) const
@@ -1173,15 +1226,15 @@ namespace astyle
    * register an in-statement indent.
    */
   void ASBeautifier::registerInStatementIndent(const std::string& line,
-      std::int32_t i,
+      std::int64_t i,
       std::int32_t spaceTabCount_,
-      std::int32_t tabIncrementIn,
+      std::int64_t tabIncrementIn,
       std::int32_t minIndent,
       bool updateParenStack)
   {
-    std::int32_t inStatementIndent;
-    std::int32_t remainingCharNum = static_cast<std::int32_t>(line.length()) - i;
-    std::int32_t nextNonWSChar    = getNextProgramCharDistance(line, i);
+    std::int64_t inStatementIndent;
+    std::int64_t remainingCharNum = static_cast<std::int64_t>(line.length()) - i;
+    std::int64_t nextNonWSChar    = getNextProgramCharDistance(line, i);
 
     // if indent is around the last char in the line, indent instead one indent from the previous indent
     if(nextNonWSChar == remainingCharNum)
@@ -1213,13 +1266,13 @@ namespace astyle
 
     if(updateParenStack)
     {
-      parenIndentStack->push_back(i + spaceTabCount_ - horstmannIndentInStatement);
+      parenIndentStack->push_back(clampIndent(i + spaceTabCount_ - horstmannIndentInStatement));
     }
 
-    std::int32_t tabIncrement = tabIncrementIn;
+    std::int64_t tabIncrement = tabIncrementIn;
 
     // check for following tabs
-    for(std::int32_t j = i + 1; j < (i + nextNonWSChar); j++)
+    for(std::int64_t j = i + 1; j < (i + nextNonWSChar); j++)
     {
       if(line[j] == '\t')
       {
@@ -1263,18 +1316,19 @@ namespace astyle
       inStatementIndent = 0;
     }
 
-    inStatementIndentStack->push_back(inStatementIndent);
+    // the indent is limited by maxInStatementIndent
+    inStatementIndentStack->push_back(static_cast<std::int32_t>(inStatementIndent));
   }
 
   /**
    * get distance to the next non-white space, non-comment character in the line.
    * if no such character exists, return the length remaining to the end of the line.
    */
-  std::int32_t ASBeautifier::getNextProgramCharDistance(const std::string& line, std::int32_t i) const
+  std::int64_t ASBeautifier::getNextProgramCharDistance(const std::string& line, std::int64_t i) const
   {
     bool inComment = false;
-    std::int32_t  remainingCharNum = static_cast<std::int32_t>(line.length()) - i;
-    std::int32_t  charDistance;
+    std::int64_t  remainingCharNum = static_cast<std::int64_t>(line.length()) - i;
+    std::int64_t  charDistance;
     char ch;
 
     for(charDistance = 1; charDistance < remainingCharNum; charDistance++)
@@ -1317,70 +1371,50 @@ namespace astyle
   }
 
 // check if a specific line position contains a header.
-  const std::string* ASBeautifier::findHeader(const std::string& line, std::int32_t i,
+// the word is scanned once and looked up in the sorted header std::vector.
+  const std::string* ASBeautifier::findHeader(const std::string& line, std::int64_t i,
       const std::vector<const std::string*>* possibleHeaders) const
   {
     assert(isCharPotentialHeader(line, i));
     // check the word
-    std::size_t maxHeaders = possibleHeaders->size();
+    const std::size_t wordEnd = getWordEnd(line, i);
+    const std::string_view word(line.data() + i, wordEnd - i);
+    std::vector<const std::string*>::const_iterator found =
+      std::lower_bound(possibleHeaders->begin(), possibleHeaders->end(), word, searchOnName);
 
-    for(std::size_t p = 0; p < maxHeaders; p++)
+    if(found == possibleHeaders->end() || std::string_view(**found) != word)
     {
-      const std::string* header = (*possibleHeaders)[p];
-      const std::size_t wordEnd = i + header->length();
-
-      if(wordEnd > line.length())
-      {
-        continue;
-      }
-
-      std::int32_t result = (line.compare(i, header->length(), *header));
-
-      if(result > 0)
-      {
-        continue;
-      }
-
-      if(result < 0)
-      {
-        break;
-      }
-
-      // check that this is not part of a longer word
-      if(wordEnd == line.length())
-      {
-        return header;
-      }
+      return nullptr;
+    }
 
-      if(isLegalNameChar(line[wordEnd]))
-      {
-        continue;
-      }
+    const std::string* header = *found;
 
-      const char peekChar = peekNextChar(line, wordEnd - 1U);
+    if(wordEnd == line.length())
+    {
+      return header;
+    }
 
-      // is not a header if part of a definition
-      if(peekChar == ',' || peekChar == ')')
-      {
-        break;
-      }
-      // the following accessor definitions are NOT headers
-      // goto default; is NOT a header
-      // default(std::int32_t) keyword in C# is NOT a header
-      else if((header == &AS_GET || header == &AS_SET || header == &AS_DEFAULT)
-              && (peekChar == ';' ||  peekChar == '('))
-      {
-        break;
-      }
+    const char peekChar = peekNextChar(line, wordEnd - 1U);
 
-      return header;
+    // is not a header if part of a definition
+    if(peekChar == ',' || peekChar == ')')
+    {
+      return nullptr;
+    }
+    // the following accessor definitions are NOT headers
+    // goto default; is NOT a header
+    // default(std::int32_t) keyword in C# is NOT a header
+    else if((header == &AS_GET || header == &AS_SET || header == &AS_DEFAULT)
+            && (peekChar == ';' ||  peekChar == '('))
+    {
+      return nullptr;
     }
 
-    return nullptr;
+    return header;
   }
 
 // check if a specific line position contains an operator.
-  const std::string* ASBeautifier::findOperator(const std::string& line, std::int32_t i,
+  const std::string* ASBeautifier::findOperator(const std::string& line, std::int64_t i,
       const std::vector<const std::string*>* possibleOperators) const
   {
     assert(isCharPotentialOperator(line[i]));
@@ -1393,7 +1427,8 @@ namespace astyle
     {
       const std::size_t wordEnd = i + (*(*possibleOperators)[p]).length();
 
-      if(wordEnd > line.length())
+      if(wordEnd > line.length()
+          || (*(*possibleOperators)[p])[0] != line[i])
       {
         continue;
       }
@@ -1411,13 +1446,16 @@ namespace astyle
    * find the index number of a std::string element in a container of strings
    *
    * @return              the index number of element in the container. -1 if element not found.
-   * @param container     a std::vector of strings.
+   * T is the type of container, a std::vector or a stack of strings.
+   *
+   * @param container     a std::vector or a stack of strings.
    * @param element       the element to find .
    */
-  std::int32_t ASBeautifier::indexOf(std::vector<const std::string*> &container,
+  template<typename T>
+  std::int32_t ASBeautifier::indexOf(T& container,
                                      const std::string* element)
   {
-    std::vector<const std::string*>::const_iterator where;
+    typename T::const_iterator where;
 
     where = find(container.begin(), container.end(), element);
 
@@ -1437,12 +1475,24 @@ namespace astyle
    * tabIncrementIn is the increment that must be added for tab indent characters
    *     to get the correct column for the current tab.
    */
-  std::int32_t ASBeautifier::convertTabToSpaces(std::int32_t i, std::int32_t tabIncrementIn) const
+  std::int32_t ASBeautifier::convertTabToSpaces(std::int64_t i, std::int64_t tabIncrementIn) const
   {
-    std::int32_t tabToSpacesAdjustment = indentLength - 1 - ((tabIncrementIn + i) % indentLength);
+    std::int32_t tabToSpacesAdjustment =
+      indentLength - 1 - static_cast<std::int32_t>((tabIncrementIn + i) % indentLength);
     return tabToSpacesAdjustment;
   }
 
+  /**
+   * clamp an indent at a character position to the range of the indent stacks.
+   * the position may be past 2^31 on a very long line.
+   */
+  std::int32_t ASBeautifier::clampIndent(std::int64_t indent) const
+  {
+    const std::int64_t maxIndent = std::numeric_limits<std::int32_t>::max();
+    const std::int64_t minIndent = std::numeric_limits<std::int32_t>::min();
+    return static_cast<std::int32_t>(std::min(std::max(indent, minIndent), maxIndent));
+  }
+
   /**
    * trim removes the white space surrounding a line.
    *
@@ -1452,8 +1502,8 @@ namespace astyle
   std::string ASBeautifier::trim(const std::string& str)
   {
 
-    std::int32_t start = 0;
-    std::int32_t end = str.length() - 1;
+    std::int64_t start = 0;
+    std::int64_t end = str.length() - 1;
 
     while(start < end && isWhiteSpace(str[start]))
     {
@@ -1474,16 +1524,16 @@ namespace astyle
    * Copy tempStacks for the copy constructor.
    * The value of the vectors must also be copied.
    */
-  std::vector<std::vector<const std::string*>*>* ASBeautifier::copyTempStacks(const ASBeautifier& other) const
+  ASStack<ASStack<const std::string*>*>* ASBeautifier::copyTempStacks(const ASBeautifier& other) const
   {
-    std::vector<std::vector<const std::string*>*> *tempStacksNew = new std::vector<std::vector<const std::string*>*>;
-    std::vector<std::vector<const std::string*>*>::iterator iter;
+    ASStack<ASStack<const std::string*>*> *tempStacksNew = stackArena->newStack<ASStack<ASStack<const std::string*>*> >();
+    ASStack<ASStack<const std::string*>*>::iterator iter;
 
     for(iter = other.tempStacks->begin();
         iter != other.tempStacks->end();
         ++iter)
     {
-      std::vector<const std::string*> *newVec = new std::vector<const std::string*>;
+      ASStack<const std::string*> *newVec = stackArena->newStack<ASStack<const std::string*> >();
 
       *newVec = **iter;
 
@@ -1499,71 +1549,119 @@ namespace astyle
   void ASBeautifier::deleteBeautifierVectors()
   {
     beautifierFileType = 9;    // reset to an invalid type
-    delete headers;
-    delete nonParenHeaders;
-    delete preBlockStatements;
-    delete preCommandHeaders;
+
+    for(std::int32_t i = 0; i <= SHARP_TYPE; i++)
+    {
+      delete beautifierVectors[i];
+      beautifierVectors[i] = nullptr;
+    }
+
     delete assignmentOperators;
     delete nonAssignmentOperators;
     delete indentableHeaders;
   }
 
   /**
-   * delete a std::vector object
-   * T is the type of std::vector
-   * used for all vectors except tempStacks
+   * delete the stack containers
+   */
+  void ASBeautifier::deleteBeautifierContainers()
+  {
+    deleteContainer(waitingBeautifierStack);
+    deleteContainer(activeBeautifierStack);
+    deleteContainer(waitingBeautifierStackLengthStack);
+    deleteContainer(activeBeautifierStackLengthStack);
+    deleteContainer(headerStack);
+    deleteContainer(tempStacks);
+    deleteContainer(blockParenDepthStack);
+    deleteContainer(blockStatementStack);
+    deleteContainer(parenStatementStack);
+    deleteContainer(bracketBlockStateStack);
+    deleteContainer(inStatementIndentStack);
+    deleteContainer(inStatementIndentStackSizeStack);
+    deleteContainer(parenIndentStack);
+  }
+
+  /**
+   * clear a stack object
+   * T is the type of stack element
+   * used for all stacks except tempStacks and the beautifier stacks
    */
   template<typename T>
-  void ASBeautifier::deleteContainer(T& container)
+  void ASBeautifier::clearContainer(ASStack<T>* container)
   {
-    if(container != nullptr)
+    container->clear();
+  }
+
+  /**
+   * Clear a waiting or active beautifier stack object.
+   * The cloned beautifiers still in the stack at the end of a file
+   * are deleted in addition to the stack entries.
+   */
+  void ASBeautifier::clearContainer(ASStack<ASBeautifier*>* container)
+  {
+    ASStack<ASBeautifier*>::iterator iter = container->begin();
+
+    for(; iter != container->end(); iter++)
     {
-      container->clear();
-      delete(container);
-      container = nullptr;
+      delete *iter;
     }
+
+    container->clear();
   }
 
   /**
-   * Delete the tempStacks std::vector object.
-   * The tempStacks is a std::vector of pointers to strings allocated with
-   * the 'new' operator.
-   * Therefore the strings have to be deleted in addition to the
+   * Clear the tempStacks stack object.
+   * The tempStacks is a stack of pointers to stacks allocated
+   * from the stack arena.
+   * Therefore the stacks have to be deleted in addition to the
    * tempStacks entries.
    */
-  void ASBeautifier::deleteContainer(std::vector<std::vector<const std::string*>*>* &container)
+  void ASBeautifier::clearContainer(ASStack<ASStack<const std::string*>*>* container)
   {
-    if(container != nullptr)
+    ASStack<ASStack<const std::string*>*>::iterator iter = container->begin();
+
+    for(; iter != container->end(); iter++)
     {
-      std::vector<std::vector<const std::string*>*>::iterator iter = container->begin();
+      stackArena->deleteStack(*iter);
+    }
 
-      for(; iter != container->end(); iter++)
-      {
-        delete *iter;
-      }
+    container->clear();
+  }
 
-      container->clear();
-      delete(container);
+  /**
+   * delete a stack object
+   * T is the type of stack element
+   * used for all stacks
+   */
+  template<typename T>
+  void ASBeautifier::deleteContainer(ASStack<T>* &container)
+  {
+    if(container != nullptr)
+    {
+      clearContainer(container);
+      stackArena->deleteStack(container);
       container = nullptr;
     }
   }
 
   /**
-   * initialize a std::vector object
-   * T is the type of std::vector
-   * used for all vectors
+   * initialize a stack object
+   * T is the type of stack element
+   * used for all stacks
    */
   template<typename T>
-  void ASBeautifier::initContainer(T& container, T value)
+  void ASBeautifier::initContainer(ASStack<T>* &container)
   {
     // since the ASFormatter object is never deleted,
-    // the existing vectors must be deleted before creating new ones
-    if(container != nullptr)
+    // the existing stacks are cleared and their capacity is reused
+    if(container == nullptr)
     {
-      deleteContainer(container);
+      container = stackArena->newStack<ASStack<T> >();
+    }
+    else
+    {
+      clearContainer(container);
     }
-
-    container = value;
   }
 
   /**
@@ -1573,26 +1671,76 @@ namespace astyle
    *
    * @return  true if line ends with a comma, otherwise false.
    */
-  bool ASBeautifier::statementEndsWithComma(const std::string& line, std::int32_t index) const
+  bool ASBeautifier::statementEndsWithComma(const std::string& line, std::int64_t index)
   {
     assert(line[index] == '=');
 
-    bool isInComment_ = false;
-    bool isInQuote_ = false;
-    std::int32_t parenCount = 0;
-    std::size_t lineLength = line.length();
-    std::size_t i = 0;
-    char quoteChar_ = ' ';
+    // A line with many assignments would be scanned to the end for each one.
+    // Instead the scan of the previous assignment on the line is reused.
+    // Only the part between the two assignments is scanned to correct the
+    // paren count. If the scan is not in the same state at the new assignment
+    // the line is scanned again from the new assignment.
+    bool isScanReused = false;
+
+    if(commaScanIndex >= 0 && index > commaScanIndex)
+    {
+      CommaScan prefix;
+      prefix.pos = commaScanIndex + 1;
+      scanStatementEnd(line, prefix, index + 1);
 
-    for(i = index + 1; i < lineLength; ++i)
+      if(!prefix.isEnded && !prefix.isInComment && !prefix.isInQuote
+          && prefix.pos == (std::size_t) index + 1)
+      {
+        commaScan.parenCount -= prefix.parenCount;
+        isScanReused = true;
+      }
+    }
+
+    if(!isScanReused)
+    {
+      commaScan = CommaScan();
+      commaScan.pos = index + 1;
+      scanStatementEnd(line, commaScan, line.length());
+    }
+
+    commaScanIndex = index;
+
+    if(commaScan.isInComment
+        || commaScan.isInQuote
+        || commaScan.parenCount > 0)
+    {
+      return false;
+    }
+
+    std::size_t lastChar = line.find_last_not_of(" \t", commaScan.pos - 1);
+
+    if(lastChar == std::string::npos || line[lastChar] != ',')
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * scan a statement for statementEndsWithComma().
+   * the scan starts at scan.pos and stops at the stop position,
+   * or at a comment that ends the line.
+   * scan.pos is updated to the position where the scan stopped.
+   */
+  void ASBeautifier::scanStatementEnd(const std::string& line, CommaScan& scan, std::size_t stop) const
+  {
+    std::size_t i = scan.pos;
+
+    for(; i < stop; ++i)
     {
       char ch = line[i];
 
-      if(isInComment_)
+      if(scan.isInComment)
       {
         if(line.compare(i, 2, "*/") == 0)
         {
-          isInComment_ = false;
+          scan.isInComment = false;
           ++i;
         }
 
@@ -1605,11 +1753,11 @@ namespace astyle
         continue;
       }
 
-      if(isInQuote_)
+      if(scan.isInQuote)
       {
-        if(ch == quoteChar_)
+        if(ch == scan.quoteChar)
         {
-          isInQuote_ = false;
+          scan.isInQuote = false;
         }
 
         continue;
@@ -1617,13 +1765,14 @@ namespace astyle
 
       if(ch == '"' || ch == '\'')
       {
-        isInQuote_ = true;
-        quoteChar_ = ch;
+        scan.isInQuote = true;
+        scan.quoteChar = ch;
         continue;
       }
 
       if(line.compare(i, 2, "//") == 0)
       {
+        scan.isEnded = true;
         break;
       }
 
@@ -1631,11 +1780,12 @@ namespace astyle
       {
         if(isLineEndComment(line, i))
         {
+          scan.isEnded = true;
           break;
         }
         else
         {
-          isInComment_ = true;
+          scan.isInComment = true;
           ++i;
           continue;
         }
@@ -1643,30 +1793,16 @@ namespace astyle
 
       if(ch == '(')
       {
-        parenCount++;
+        scan.parenCount++;
       }
 
       if(ch == ')')
       {
-        parenCount--;
+        scan.parenCount--;
       }
     }
 
-    if(isInComment_
-        || isInQuote_
-        || parenCount > 0)
-    {
-      return false;
-    }
-
-    std::size_t lastChar = line.find_last_not_of(" \t", i - 1);
-
-    if(lastChar == std::string::npos || line[lastChar] != ',')
-    {
-      return false;
-    }
-
-    return true;
+    scan.pos = i;
   }
 
   /**
@@ -1674,7 +1810,7 @@ namespace astyle
    *
    * @return     is before a line-end comment.
    */
-  bool ASBeautifier::isLineEndComment(const std::string& line, std::int32_t startPos) const
+  bool ASBeautifier::isLineEndComment(const std::string& line, std::int64_t startPos) const
   {
     assert(line.compare(startPos, 2, "/*") == 0);
 
@@ -1699,7 +1835,7 @@ namespace astyle
    *
    * @return is the index to the previous word (the in statement indent).
    */
-  std::int32_t ASBeautifier::getInStatementIndentAssign(const std::string& line, std::size_t currPos) const
+  std::int64_t ASBeautifier::getInStatementIndentAssign(const std::string& line, std::size_t currPos) const
   {
     assert(line[currPos] == '=');
 
@@ -1716,7 +1852,7 @@ namespace astyle
       return 0;
     }
 
-    std::int32_t start;          // start of the previous word
+    std::int64_t start;          // start of the previous word
 
     for(start = end; start > -1; start--)
     {
@@ -1736,7 +1872,7 @@ namespace astyle
    *
    * @return is the indent to the second word on the line (the in statement indent).
    */
-  std::int32_t ASBeautifier::getInStatementIndentComma(const std::string& line, std::size_t currPos) const
+  std::int64_t ASBeautifier::getInStatementIndentComma(const std::string& line, std::size_t currPos) const
   {
     assert(line[currPos] == ',');
 
@@ -2054,6 +2190,7 @@ namespace astyle
    */
   void ASBeautifier::parseCurrentLine(const std::string& line)
   {
+    commaScanIndex = -1;            // a new line for statementEndsWithComma()
     bool isInLineComment = false;
     bool isInOperator = false;
     bool isSpecialChar = false;
@@ -2064,7 +2201,7 @@ namespace astyle
     char ch = ' ';
     char prevCh;
     char tempCh;
-    std::int32_t tabIncrementIn = 0;
+    std::int64_t tabIncrementIn = 0;
 
     for(std::size_t i = 0; i < line.length(); i++)
     {
@@ -2196,11 +2333,8 @@ namespace astyle
       if(isInComment || isInLineComment)
       {
         // bypass rest of the comment up to the comment end
-        while(i + 1 < line.length()
-              && line.compare(i + 1, 2, "*/") != 0)
-        {
-          i++;
-        }
+        std::size_t commentEnd = line.find("*/", i + 1);
+        i = (commentEnd == std::string::npos) ? line.length() - 1 : commentEnd - 1;
 
         continue;
       }
@@ -2451,9 +2585,9 @@ namespace astyle
             if(headerStack->size() > 0
                 && (*headerStack).back() == &AS_CLASS)
             {
-              std::int32_t nextChar = getNextProgramCharDistance(line, i);
+              std::int64_t nextChar = getNextProgramCharDistance(line, i);
 
-              if((std::int32_t)line.length() > nextChar && line[nextChar] == '}')
+              if((std::int64_t)line.length() > nextChar && line[nextChar] == '}')
               {
                 tabCount--;
               }
@@ -2492,7 +2626,7 @@ namespace astyle
         isInStatement = false;
         foundPreCommandHeader = false;
 
-        tempStacks->push_back(new std::vector<const std::string*>);
+        tempStacks->push_back(stackArena->newStack<ASStack<const std::string*> >());
         headerStack->push_back(&AS_OPEN_BRACKET);
         lastLineHeader = &AS_OPEN_BRACKET;
 
@@ -2513,7 +2647,7 @@ namespace astyle
 
           isInHeader = true;
 
-          std::vector<const std::string*> *lastTempStack;
+          ASStack<const std::string*> *lastTempStack;
 
           if(tempStacks->empty())
           {
@@ -2831,8 +2965,8 @@ namespace astyle
 
               if(firstChar != std::string::npos)
               {
-                std::int32_t inStatementIndent = firstWord + spaceTabCount + tabIncrementIn;
-                inStatementIndentStack->push_back(inStatementIndent);
+                std::int64_t inStatementIndent = firstWord + spaceTabCount + tabIncrementIn;
+                inStatementIndentStack->push_back(clampIndent(inStatementIndent));
                 isInStatement = true;
               }
             }
@@ -2840,9 +2974,9 @@ namespace astyle
           // register indent at previous word
           else
           {
-            std::int32_t prevWord = getInStatementIndentComma(line, i);
-            std::int32_t inStatementIndent = prevWord + spaceTabCount + tabIncrementIn;
-            inStatementIndentStack->push_back(inStatementIndent);
+            std::int64_t prevWord = getInStatementIndentComma(line, i);
+            std::int64_t inStatementIndent = prevWord + spaceTabCount + tabIncrementIn;
+            inStatementIndentStack->push_back(clampIndent(inStatementIndent));
             isInStatement = true;
           }
         }
@@ -2958,9 +3092,9 @@ namespace astyle
 
             if(!tempStacks->empty())
             {
-              std::vector<const std::string*> *temp =  tempStacks->back();
+              ASStack<const std::string*> *temp =  tempStacks->back();
               tempStacks->pop_back();
-              delete temp;
+              stackArena->deleteStack(temp);
             }
           }
 
@@ -3098,8 +3232,7 @@ namespace astyle
         }
 
         // bypass the entire name for all others
-        std::string name = getCurrentWord(line, i);
-        i += name.length() - 1;
+        i = getWordEnd(line, i) - 1;
         continue;
       }
 
@@ -3176,9 +3309,9 @@ namespace astyle
               {
                 // register indent at previous word
                 haveAssignmentThisLine = true;
-                std::int32_t prevWordIndex = getInStatementIndentAssign(line, i);
-                std::int32_t inStatementIndent = prevWordIndex + spaceTabCount + tabIncrementIn;
-                inStatementIndentStack->push_back(inStatementIndent);
+                std::int64_t prevWordIndex = getInStatementIndentAssign(line, i);
+                std::int64_t inStatementIndent = prevWordIndex + spaceTabCount + tabIncrementIn;
+                inStatementIndentStack->push_back(clampIndent(inStatementIndent));
               }
             }
             else
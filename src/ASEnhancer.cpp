@@ -152,6 +152,21 @@ namespace astyle
     {
       char ch = line[i];
 
+      // bypass the rest of a comment up to the comment end
+      if(isInComment)
+      {
+        std::size_t commentEnd = line.find("*/", i);
+
+        if(commentEnd == std::string::npos)
+        {
+          break;
+        }
+
+        isInComment = false;
+        i = commentEnd + 1;
+        continue;
+      }
+
       // bypass whitespace
       if(isWhiteSpace(ch))
       {
@@ -165,20 +180,22 @@ namespace astyle
         continue;
       }
 
-      if(!(isInComment) && line.compare(i, 2, "\\\\") == 0)
+      if(ch == '\\')
       {
-        i++;
-        continue;
-      }
+        if(i + 1 < line.length() && line[i + 1] == '\\')
+        {
+          i++;
+        }
+        else
+        {
+          isSpecialChar = true;
+        }
 
-      if(!(isInComment) && ch == '\\')
-      {
-        isSpecialChar = true;
         continue;
       }
 
       // handle quotes (such as 'x' and "Hello Dolly")
-      if(!isInComment && (ch == '"' || ch == '\''))
+      if(ch == '"' || ch == '\'')
       {
         if(!isInQuote)
         {
@@ -199,7 +216,7 @@ namespace astyle
 
       // handle comments
 
-      if(!(isInComment) && line.compare(i, 2, "//") == 0)
+      if(ch == '/' && i + 1 < line.length() && line[i + 1] == '/')
       {
         // check for windows line markers
         if(line.compare(i + 2, 1, "\xf0") > 0)
@@ -209,23 +226,12 @@ namespace astyle
 
         break;                 // finished with the line
       }
-      else if(!(isInComment) && line.compare(i, 2, "/*") == 0)
+      else if(ch == '/' && i + 1 < line.length() && line[i + 1] == '*')
       {
         isInComment = true;
         i++;
         continue;
       }
-      else if((isInComment) && line.compare(i, 2, "*/") == 0)
-      {
-        isInComment = false;
-        i++;
-        continue;
-      }
-
-      if(isInComment)
-      {
-        continue;
-      }
 
       // if we have reached this far then we are NOT in a comment or std::string of special characters
 
@@ -243,7 +249,8 @@ namespace astyle
 
       // ----------------  wxWidgets and MFC macros  ----------------------------------
 
-      if(isPotentialKeyword)
+      // the macros all begin with "BEGIN_" or "END_"
+      if(isPotentialKeyword && (ch == 'B' || ch == 'E'))
       {
         if(findKeyword(line, i, "BEGIN_EVENT_TABLE")
             || findKeyword(line, i, "BEGIN_DISPATCH_MAP")
@@ -304,8 +311,7 @@ namespace astyle
         // bypass the entire word
         if(isPotentialKeyword)
         {
-          std::string name = getCurrentWord(line, i);
-          i += name.length() - 1;
+          i = getWordEnd(line, i) - 1;
         }
 
         continue;
@@ -568,18 +574,18 @@ namespace astyle
    * @return     false = one-line bracket has not been reached.
    *             true  = one-line bracket has been reached.
    */
-  bool ASEnhancer::isOneLineBlockReached(std::string& line, std::int32_t startChar) const
+  bool ASEnhancer::isOneLineBlockReached(std::string& line, std::int64_t startChar) const
   {
     assert(line[startChar] == '{');
 
     bool isInComment_ = false;
     bool isInQuote_ = false;
     std::int32_t _bracketCount = 1;
-    std::int32_t lineLength = line.length();
+    std::int64_t lineLength = line.length();
     char quoteChar_ = ' ';
     char ch = ' ';
 
-    for(std::int32_t i = startChar + 1; i < lineLength; ++i)
+    for(std::int64_t i = startChar + 1; i < lineLength; ++i)
     {
       ch = line[i];
 
@@ -752,9 +758,7 @@ namespace astyle
 
     if(isPotentialKeyword)
     {
-      std::string name = getCurrentWord(line, i);          // bypass the entire name
-
-      i += name.length() - 1;
+      i = getWordEnd(line, i) - 1;          // bypass the entire name
     }
 
     return i;
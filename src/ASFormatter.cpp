@@ -70,12 +70,18 @@ namespace astyle
     shouldAddOneLineBrackets = false;
 
     // initialize ASFormatter member vectors
+    // the language vectors are set by buildLanguageVectors()
     formatterFileType = 9;    // reset to an invalid type
 
-    headers              = new std::vector<const std::string*>;
-    nonParenHeaders      = new std::vector<const std::string*>;
-    preDefinitionHeaders = new std::vector<const std::string*>;
-    preCommandHeaders    = new std::vector<const std::string*>;
+    for(std::int32_t i = 0; i <= SHARP_TYPE; i++)
+    {
+      formatterVectors[i] = nullptr;
+    }
+
+    headers              = nullptr;
+    nonParenHeaders      = nullptr;
+    preDefinitionHeaders = nullptr;
+    preCommandHeaders    = nullptr;
     operators            = new std::vector<const std::string*>;
     assignmentOperators  = new std::vector<const std::string*>;
     castOperators        = new std::vector<const std::string*>;
@@ -98,10 +104,12 @@ namespace astyle
 
     // delete ASFormatter member vectors
     formatterFileType = 9;    // reset to an invalid type
-    delete headers;
-    delete nonParenHeaders;
-    delete preDefinitionHeaders;
-    delete preCommandHeaders;
+
+    for(std::int32_t i = 0; i <= SHARP_TYPE; i++)
+    {
+      delete formatterVectors[i];
+    }
+
     delete operators;
     delete assignmentOperators;
     delete castOperators;
@@ -137,11 +145,11 @@ namespace astyle
                    getEmptyLineFill());
     sourceIterator = si;
 
-    initContainer(preBracketHeaderStack, new std::vector<const std::string*>);
-    initContainer(parenStack, new std::vector<std::int32_t>);
-    initContainer(structStack, new std::vector<bool>);
+    initContainer(preBracketHeaderStack);
+    initContainer(parenStack);
+    initContainer(structStack);
     parenStack->push_back(0);               // parenStack must contain this default entry
-    initContainer(bracketTypeStack, new std::vector<BracketType>);
+    initContainer(bracketTypeStack);
     bracketTypeStack->push_back(NULL_TYPE); // bracketTypeStack must contain this default entry
 
     currentHeader = nullptr;
@@ -256,18 +264,21 @@ namespace astyle
 
     formatterFileType = getFileType();
 
-    headers->clear();
-    nonParenHeaders->clear();
-    preDefinitionHeaders->clear();
-    preCommandHeaders->clear();
-    operators->clear();
-    assignmentOperators->clear();
-    castOperators->clear();
+    // the vectors for a file type are built only once
+    // and reused when another file of the same type is formatted
+    if(formatterVectors[formatterFileType] == nullptr)
+    {
+      formatterVectors[formatterFileType] = new FormatterVectors;
+      ASResource::buildHeaders(&formatterVectors[formatterFileType]->headers, getFileType());
+      ASResource::buildNonParenHeaders(&formatterVectors[formatterFileType]->nonParenHeaders, getFileType());
+      ASResource::buildPreDefinitionHeaders(&formatterVectors[formatterFileType]->preDefinitionHeaders, getFileType());
+      ASResource::buildPreCommandHeaders(&formatterVectors[formatterFileType]->preCommandHeaders, getFileType());
+    }
 
-    ASResource::buildHeaders(headers, getFileType());
-    ASResource::buildNonParenHeaders(nonParenHeaders, getFileType());
-    ASResource::buildPreDefinitionHeaders(preDefinitionHeaders, getFileType());
-    ASResource::buildPreCommandHeaders(preCommandHeaders, getFileType());
+    headers = &formatterVectors[formatterFileType]->headers;
+    nonParenHeaders = &formatterVectors[formatterFileType]->nonParenHeaders;
+    preDefinitionHeaders = &formatterVectors[formatterFileType]->preDefinitionHeaders;
+    preCommandHeaders = &formatterVectors[formatterFileType]->preCommandHeaders;
 
     if(operators->size() == 0)
     {
@@ -387,6 +398,21 @@ namespace astyle
    * @return    formatted line.
    */
   std::string ASFormatter::nextLine()
+  {
+    std::string formattedOutLine;
+    nextLine(formattedOutLine);
+    return formattedOutLine;
+  }
+
+  /**
+   * get the next formatted line and append it to a buffer owned by the caller.
+   * the end of line is not appended.
+   * the buffers used by the formatter keep their capacity,
+   * so no memory is allocated for a line once they are large enough.
+   *
+   * @param outBuffer     the buffer the formatted line is appended to.
+   */
+  void ASFormatter::nextLine(std::string& outBuffer)
   {
     const std::string* newHeader;
     bool isInVirginLine = isVirgin;
@@ -594,7 +620,7 @@ namespace astyle
             std::size_t firstText = currentLine.find_first_not_of(" \t");
             assert(firstText != std::string::npos);
 
-            if((std::int32_t) firstText == charNum)
+            if((std::int64_t) firstText == charNum)
             {
               breakCurrentOneLineBlock = true;
             }
@@ -981,7 +1007,7 @@ namespace astyle
               && (!isNonParenHeader
                   || (currentHeader == &AS_CASE && peekNextChar() == '(')
                   || (currentHeader == &AS_CATCH && peekNextChar() == '('))
-              && charNum < (std::int32_t) currentLine.length() - 1 && !isWhiteSpace(currentLine[charNum + 1]))
+              && charNum < (std::int64_t) currentLine.length() - 1 && !isWhiteSpace(currentLine[charNum + 1]))
           {
             appendSpacePad();
           }
@@ -1306,7 +1332,7 @@ namespace astyle
       {
         char nextChar = ' ';
 
-        if(charNum + 1 < (std::int32_t) currentLine.length())
+        if(charNum + 1 < (std::int64_t) currentLine.length())
         {
           nextChar = currentLine[charNum + 1];
         }
@@ -1348,15 +1374,21 @@ namespace astyle
 
     // return a beautified (i.e. correctly indented) line.
 
-    std::string beautifiedLine;
-    std::size_t readyFormattedLineLength = trim(readyFormattedLine).length();
+    beautifiedLine.clear();
+    std::size_t readyFormattedLineLength = 0;
+    std::size_t firstText = readyFormattedLine.find_first_not_of(" \t");
+
+    if(firstText != std::string::npos)
+    {
+      readyFormattedLineLength = readyFormattedLine.find_last_not_of(" \t") + 1 - firstText;
+    }
 
     if(prependEmptyLine                 // prepend a blank line before this formatted line
         && readyFormattedLineLength > 0
         && previousReadyFormattedLineLength > 0)
     {
       isLineReady = true;             // signal a waiting readyFormattedLine
-      beautifiedLine = beautify("");
+      beautify(std::string(), beautifiedLine);
       previousReadyFormattedLineLength = 0;
       // call the enhancer for new empty lines
       enhancer->enhance(beautifiedLine, isInPreprocessorBeautify, isInBeautifySQL);
@@ -1365,7 +1397,7 @@ namespace astyle
     {
       isLineReady = false;
       horstmannIndentInStatement = horstmannIndentChars;
-      beautifiedLine = beautify(readyFormattedLine);
+      beautify(readyFormattedLine, beautifiedLine);
       previousReadyFormattedLineLength = readyFormattedLineLength;
 
       // the enhancer is not called for no-indent line comments
@@ -1389,8 +1421,8 @@ namespace astyle
     }
 
     prependEmptyLine = false;
-    assert(computeChecksumOut(beautifiedLine));
-    return beautifiedLine;
+    computeChecksumOut(beautifiedLine);
+    outBuffer.append(beautifiedLine);
   }
 
 
@@ -1663,7 +1695,7 @@ namespace astyle
    *
    * @param i       the number of characters to jump over.
    */
-  void ASFormatter::goForward(std::int32_t i)
+  void ASFormatter::goForward(std::int64_t i)
   {
     while(--i >= 0)
     {
@@ -1738,7 +1770,7 @@ namespace astyle
    *
    * @return     is before a comment or line-comment.
    */
-  bool ASFormatter::isBeforeAnyLineEndComment(std::int32_t startPos) const
+  bool ASFormatter::isBeforeAnyLineEndComment(std::int64_t startPos) const
   {
     bool foundLineEndComment = false;
     std::size_t peekNum = currentLine.find_first_not_of(" \t", startPos + 1);
@@ -1774,7 +1806,7 @@ namespace astyle
    *
    * @return     is before a multiple line-end comment.
    */
-  bool ASFormatter::isBeforeMultipleLineEndComments(std::int32_t startPos) const
+  bool ASFormatter::isBeforeMultipleLineEndComments(std::int64_t startPos) const
   {
     bool foundMultipleLineEndComment = false;
     std::size_t peekNum = currentLine.find_first_not_of(" \t", startPos + 1);
@@ -1829,16 +1861,10 @@ namespace astyle
       }
     }
 
-    if(charNum + 1 < (std::int32_t) currentLine.length()
+    if(charNum + 1 < (std::int64_t) currentLine.length()
         && (!isWhiteSpace(peekNextChar()) || isInComment || isInLineComment))
     {
       currentChar = currentLine[++charNum];
-
-      if(shouldConvertTabs && currentChar == '\t')
-      {
-        convertTabToSpaces();
-      }
-
       return true;
     }
 
@@ -1854,7 +1880,9 @@ namespace astyle
    */
   bool ASFormatter::getNextLine(bool emptyLineWasDeleted /*false*/)
   {
-    if(sourceIterator->hasMoreLines())
+    // empty lines that are deleted are skipped by the loop instead of a recursive call
+    // so a long run of empty lines does not use the stack.
+    while(sourceIterator->hasMoreLines())
     {
       if(appendOpeningBracket)
       {
@@ -1863,7 +1891,7 @@ namespace astyle
       else
       {
         currentLine = sourceIterator->nextLine(emptyLineWasDeleted);
-        assert(computeChecksumIn(currentLine));
+        computeChecksumIn(currentLine);
       }
 
       // reset variables for new line
@@ -1922,13 +1950,13 @@ namespace astyle
 
       isInHorstmannRunIn = false;
 
-      if(shouldConvertTabs && currentChar == '\t')
+      if(shouldConvertTabs)
       {
         convertTabToSpaces();
       }
 
       // check for an empty line inside a command bracket.
-      // if yes then read the next line (calls getNextLine recursively).
+      // if yes then read the next line.
       // must be after initNewLine.
       if(shouldDeleteEmptyLines
           && lineIsEmpty
@@ -1938,17 +1966,16 @@ namespace astyle
         {
           isInPreprocessor = isImmediatelyPostPreprocessor;    // restore
           lineIsEmpty = false;
-          return getNextLine(true);
+          emptyLineWasDeleted = true;
+          continue;
         }
       }
 
       return true;
     }
-    else
-    {
-      endOfCodeReached = true;
-      return false;
-    }
+
+    endOfCodeReached = true;
+    return false;
   }
 
   /**
@@ -2019,7 +2046,7 @@ namespace astyle
     currentLineFirstBracketNum = std::string::npos;
     tabIncrementIn = 0;
 
-    for(charNum = 0; isWhiteSpace(currentLine[charNum]) && charNum + 1 < (std::int32_t) len; charNum++)
+    for(charNum = 0; isWhiteSpace(currentLine[charNum]) && charNum + 1 < (std::int64_t) len; charNum++)
     {
       if(currentLine[charNum] == '\t')
       {
@@ -2072,7 +2099,7 @@ namespace astyle
         }
       }
     }
-    else if(isWhiteSpace(currentLine[charNum]) && !(charNum + 1 < (std::int32_t) currentLine.length()))
+    else if(isWhiteSpace(currentLine[charNum]) && !(charNum + 1 < (std::int64_t) currentLine.length()))
     {
       lineIsEmpty = true;
     }
@@ -2104,7 +2131,7 @@ namespace astyle
    */
   void ASFormatter::appendSpacePad()
   {
-    std::int32_t len = formattedLine.length();
+    std::int64_t len = formattedLine.length();
 
     if(len > 0 && !isWhiteSpace(formattedLine[len - 1]))
     {
@@ -2119,7 +2146,7 @@ namespace astyle
    */
   void ASFormatter::appendSpaceAfter()
   {
-    std::int32_t len = currentLine.length();
+    std::int64_t len = currentLine.length();
 
     if(charNum + 1 < len && !isWhiteSpace(currentLine[charNum + 1]))
     {
@@ -2152,8 +2179,9 @@ namespace astyle
       isPrependPostBlockEmptyLineRequested = false;
     }
 
-    readyFormattedLine =  formattedLine;
-    formattedLine = "";
+    // swap the buffers instead of copying, both keep their capacity
+    readyFormattedLine.swap(formattedLine);
+    formattedLine.clear();
   }
 
   /**
@@ -2412,7 +2440,7 @@ namespace astyle
 
     // check for **
     if(currentChar == '*'
-        && (std::int32_t) currentLine.length() > charNum
+        && (std::int64_t) currentLine.length() > charNum
         && currentLine[charNum + 1] == '*')
     {
       if(previousNonWSChar == '(')
@@ -2420,7 +2448,7 @@ namespace astyle
         return true;
       }
 
-      if((std::int32_t) currentLine.length() < charNum + 2)
+      if((std::int64_t) currentLine.length() < charNum + 2)
       {
         return true;
       }
@@ -2429,7 +2457,7 @@ namespace astyle
     }
 
     // check first char on the line
-    if(charNum == (std::int32_t) currentLine.find_first_not_of(" \t"))
+    if(charNum == (std::int64_t) currentLine.find_first_not_of(" \t"))
     {
       return true;
     }
@@ -2477,8 +2505,8 @@ namespace astyle
   {
     assert(currentLine[charNum] == '*' || currentLine[charNum] == '&');
 
-    std::int32_t prNum = charNum;
-    std::int32_t lineLength = (std::int32_t) currentLine.length();
+    std::int64_t prNum = charNum;
+    std::int64_t lineLength = (std::int64_t) currentLine.length();
 
     // check for end of  line
     if(peekNextChar() == ' ')
@@ -2557,7 +2585,7 @@ namespace astyle
   {
     assert(currentChar == '+' || currentChar == '-');
 
-    std::int32_t formattedLineLength = formattedLine.length();
+    std::int64_t formattedLineLength = formattedLine.length();
 
     if(formattedLineLength >= 2)
     {
@@ -2585,7 +2613,7 @@ namespace astyle
 
     // if this opening bracket begins the line there will be no inStatement indent
     if(currentLineBeginsWithBracket
-        && charNum == (std::int32_t) currentLineFirstBracketNum
+        && charNum == (std::int64_t) currentLineFirstBracketNum
         && nextChar != '}')
     {
       returnVal = true;
@@ -2623,19 +2651,19 @@ namespace astyle
    *             1 = one-line bracket has been reached.
    *             2 = one-line bracket has been reached and is followed by a comma.
    */
-  std::int32_t ASFormatter::isOneLineBlockReached(std::string& line, std::int32_t startChar) const
+  std::int32_t ASFormatter::isOneLineBlockReached(std::string& line, std::int64_t startChar) const
   {
     assert(line[startChar] == '{');
 
     bool isInComment_ = false;
     bool isInQuote_ = false;
     std::int32_t bracketCount = 1;
-    std::int32_t lineLength = line.length();
+    std::int64_t lineLength = line.length();
     char quoteChar_ = ' ';
     char ch = ' ';
     char prevCh = ' ';
 
-    for(std::int32_t i = startChar + 1; i < lineLength; ++i)
+    for(std::int64_t i = startChar + 1; i < lineLength; ++i)
     {
       ch = line[i];
 
@@ -2726,7 +2754,7 @@ namespace astyle
    * @param       char position on currentLine to start the search
    * @return      true if the next word is get or set.
    */
-  bool ASFormatter::isNextWordSharpNonParenHeader(std::int32_t startChar) const
+  bool ASFormatter::isNextWordSharpNonParenHeader(std::int64_t startChar) const
   {
     // look ahead to find the next non-comment text
     std::string nextText = peekNextText(currentLine.substr(startChar));
@@ -2763,7 +2791,7 @@ namespace astyle
    * @param       char position on currentLine to start the search
    * @return      true if the next word is an opening bracket.
    */
-  bool ASFormatter::isNextCharOpeningBracket(std::int32_t startChar) const
+  bool ASFormatter::isNextCharOpeningBracket(std::int64_t startChar) const
   {
     bool retVal = false;
     std::string nextText = peekNextText(currentLine.substr(startChar));
@@ -2906,14 +2934,14 @@ namespace astyle
     // if spaces were removed, need to add spaces before the comment
     if(spacePadNum < 0)
     {
-      std::int32_t adjust = -spacePadNum;          // make the number positive
+      std::int64_t adjust = -spacePadNum;          // make the number positive
       formattedLine.append(adjust, ' ');
     }
     // if spaces were added, need to delete extra spaces before the comment
     // if cannot be done put the comment one space after the last text
     else if(spacePadNum > 0)
     {
-      std::int32_t adjust = spacePadNum;
+      std::int64_t adjust = spacePadNum;
       std::size_t lastText = formattedLine.find_last_not_of(' ');
 
       if(lastText != std::string::npos
@@ -3080,7 +3108,7 @@ namespace astyle
     char peekedChar = peekNextChar();
 
     if(currentChar == '*'
-        && (std::int32_t) currentLine.length() > charNum + 1
+        && (std::int64_t) currentLine.length() > charNum + 1
         && currentLine[charNum + 1] == '*')
     {
       std::size_t nextChar = currentLine.find_first_not_of(" \t", charNum + 2);
@@ -3142,7 +3170,7 @@ namespace astyle
       }
 
       // if no space after * then add one
-      if(charNum < (std::int32_t) currentLine.length() - 1
+      if(charNum < (std::int64_t) currentLine.length() - 1
           && !isWhiteSpace(currentLine[charNum + 1])
           && currentLine[charNum + 1] != ')')
       {
@@ -3193,7 +3221,7 @@ namespace astyle
       }
 
       // if this is not the last thing on the line
-      if((std::int32_t) currentLine.find_first_not_of(" \t", charNum + 1) > charNum)
+      if((std::int64_t) currentLine.find_first_not_of(" \t", charNum + 1) > charNum)
       {
         // goForward() to convert tabs to spaces, if necessary,
         // and move following characters to preceding characters
@@ -3264,7 +3292,7 @@ namespace astyle
 
       // if this is not the last thing on the line
       if(!isBeforeAnyComment()
-          && (std::int32_t) currentLine.find_first_not_of(" \t", charNum + 1) > charNum)
+          && (std::int64_t) currentLine.find_first_not_of(" \t", charNum + 1) > charNum)
       {
         // goForward() to convert tabs to spaces, if necessary,
         // and move following characters to preceding characters
@@ -3387,8 +3415,8 @@ namespace astyle
   {
     assert(currentChar == '(' || currentChar == ')');
 
-    std::int32_t spacesOutsideToDelete = 0;
-    std::int32_t spacesInsideToDelete = 0;
+    std::int64_t spacesOutsideToDelete = 0;
+    std::int64_t spacesInsideToDelete = 0;
 
     if(currentChar == '(')
     {
@@ -3530,7 +3558,7 @@ namespace astyle
 
         // convert tab to space if requested
         if(shouldConvertTabs
-            && (std::int32_t)currentLine.length() > charNum + 1
+            && (std::int64_t)currentLine.length() > charNum + 1
             && currentLine[charNum + 1] == '\t')
         {
           currentLine[charNum + 1] = ' ';
@@ -3796,7 +3824,7 @@ namespace astyle
       if((isEmptyLine(formattedLine)      // if a blank line preceeds this
           || isCharImmediatelyPostLineComment
           || isCharImmediatelyPostComment
-          || (isImmediatelyPostPreprocessor && (std::int32_t) currentLine.find_first_not_of(" \t") == charNum)
+          || (isImmediatelyPostPreprocessor && (std::int64_t) currentLine.find_first_not_of(" \t") == charNum)
 //            || (isBracketType(bracketType, CLASS_TYPE) && isOkToBreakBlock(bracketType) && previousNonWSChar != '{')
 //            || (isBracketType(bracketType, NAMESPACE_TYPE) && isOkToBreakBlock(bracketType) && previousNonWSChar != '{')
          )
@@ -3909,7 +3937,7 @@ namespace astyle
                 appendCurrentChar(false);       // OK to attach
 
                 if(currentLineBeginsWithBracket
-                    && (std::int32_t)currentLineFirstBracketNum == charNum)
+                    && (std::int64_t)currentLineFirstBracketNum == charNum)
                 {
                   shouldBreakLineAtNextChar = true;
                 }
@@ -3946,7 +3974,7 @@ namespace astyle
           appendCurrentChar();
 
           if(currentLineBeginsWithBracket
-              && (std::int32_t)currentLineFirstBracketNum == charNum
+              && (std::int64_t)currentLineFirstBracketNum == charNum
               && !isBracketType(bracketType, SINGLE_LINE_TYPE))
           {
             shouldBreakLineAtNextChar = true;
@@ -4211,88 +4239,174 @@ namespace astyle
   }
 
   /**
-   * delete a bracketTypeStack std::vector object
-   * BracketTypeStack did not work with the DeleteContainer template
+   * delete a stack object
+   * T is the type of stack element
+   * used for all stacks
    */
-  void ASFormatter::deleteContainer(std::vector<BracketType>* &container)
+  template<typename T>
+  void ASFormatter::deleteContainer(ASStack<T>* &container)
   {
     if(container != nullptr)
     {
-      container->clear();
-      delete(container);
+      stackArena->deleteStack(container);
       container = nullptr;
     }
   }
 
   /**
-   * delete a std::vector object
-   * T is the type of std::vector
-   * used for all vectors except bracketTypeStack
+   * initialize a stack object
+   * T is the type of stack element
+   * used for all stacks
    */
   template<typename T>
-  void ASFormatter::deleteContainer(T& container)
+  void ASFormatter::initContainer(ASStack<T>* &container)
   {
-    if(container != nullptr)
+    // since the ASFormatter object is never deleted,
+    // the existing stacks are cleared and their capacity is reused
+    if(container == nullptr)
+    {
+      container = stackArena->newStack<ASStack<T> >();
+    }
+    else
     {
       container->clear();
-      delete(container);
-      container = nullptr;
     }
   }
 
   /**
-   * initialize a BracketType std::vector object
-   * BracketType did not work with the DeleteContainer template
+   * convert tabs to spaces.
+   * the tabs from charNum to the end of currentLine are expanded in a single pass
+   *     when the line is read, so a line with many tabs is not shifted once for each tab.
+   * tabIncrementIn is the increment that must be added for tab indent characters
+   *     to get the correct column for each tab.
+   * the quote and comment state is tracked in the pass, starting from the state
+   *     at the beginning of the line. tabs in quotes are NOT converted.
+   * replaces the value of currentChar.
    */
-  void ASFormatter::initContainer(std::vector<BracketType>* &container, std::vector<BracketType>* value)
+  void ASFormatter::convertTabToSpaces()
   {
-    if(container != nullptr)
+    // do NOT replace if in quotes
+    if(isInQuote || isInQuoteContinuation)
     {
-      deleteContainer(container);
+      return;
     }
 
-    container = value;
-  }
-
-  /**
-   * initialize a std::vector object
-   * T is the type of std::vector
-   * used for all vectors except bracketTypeStack
-   */
-  template<typename T>
-  void ASFormatter::initContainer(T& container, T value)
-  {
-    // since the ASFormatter object is never deleted,
-    // the existing vectors must be deleted before creating new ones
-    if(container != nullptr)
+    if(currentLine.find('\t', charNum) == std::string::npos)
     {
-      deleteContainer(container);
+      return;
     }
 
-    container = value;
-  }
+    const std::size_t len = currentLine.length();
+    const std::size_t indent = getIndentLength();
+    const bool isTabIndent = (getIndentString() == "\t");
+    bool isInCommentNow = isInComment;
+    bool isInLineCommentNow = false;
+    bool isInSQLNow = isInExecSQL && !passedSemicolon;
+    bool isInVerbatim = false;
+    char quote = 0;                     // the open quote char, zero if not in a quote
 
-  /**
-   * convert a tab to spaces.
-   * charNum points to the current character to convert to spaces.
-   * tabIncrementIn is the increment that must be added for tab indent characters
-   *     to get the correct column for the current tab.
-   * replaces the tab in currentLine with the required number of spaces.
-   * replaces the value of currentChar.
-   */
-  void ASFormatter::convertTabToSpaces()
-  {
-    assert(currentLine[charNum] == '\t');
+    tabExpansion.assign(currentLine, 0, charNum);
 
-    // do NOT replace if in quotes
-    if(isInQuote || isInQuoteContinuation)
+    for(std::size_t i = charNum; i < len; i++)
     {
-      return;
+      char ch = currentLine[i];
+
+      if(ch == '\t' && quote == 0)
+      {
+        tabExpansion.append(indent - ((tabIncrementIn + tabExpansion.length()) % indent), ' ');
+        continue;
+      }
+
+      tabExpansion.push_back(ch);
+
+      if(isInLineCommentNow)
+      {
+        continue;
+      }
+
+      char nextCh = (i + 1 < len) ? currentLine[i + 1] : ' ';
+
+      if(isInCommentNow)
+      {
+        if(ch == '*' && nextCh == '/')
+        {
+          tabExpansion.push_back(currentLine[++i]);
+          isInCommentNow = false;
+        }
+      }
+      else if(quote != 0)
+      {
+        if(ch == '\\' && !isInVerbatim)
+        {
+          // the escaped char is appended with the quote
+          if(i + 1 < len)
+          {
+            tabExpansion.push_back(currentLine[++i]);
+          }
+        }
+        else if(isInVerbatim && ch == '"' && nextCh == '"')
+        {
+          tabExpansion.push_back(currentLine[++i]);
+        }
+        else if(ch == quote)
+        {
+          quote = 0;
+          isInVerbatim = false;
+        }
+      }
+      else if(isInSQLNow)
+      {
+        if(ch == ';')
+        {
+          isInSQLNow = false;
+        }
+      }
+      else if(ch == '/' && nextCh == '/')
+      {
+        tabExpansion.push_back(currentLine[++i]);
+        isInLineCommentNow = true;
+
+        // if tabbed input don't convert the tabs immediately following a column 1 comment
+        if(isTabIndent && !shouldIndentCol1Comments
+            && (i == 1 || (i == 2 && currentLine[0] == ' ')))
+        {
+          while(i + 1 < len && currentLine[i + 1] == '\t')
+          {
+            tabExpansion.push_back(currentLine[++i]);
+          }
+        }
+      }
+      else if(ch == '/' && nextCh == '*')
+      {
+        tabExpansion.push_back(currentLine[++i]);
+        isInCommentNow = true;
+      }
+      else if(ch == '"' || ch == '\'')
+      {
+        quote = ch;
+        isInVerbatim = (ch == '"' && isSharpStyle() && i > 0 && currentLine[i - 1] == '@');
+      }
+      // these preprocessor statements are treated as a line comment
+      else if(ch == '#')
+      {
+        std::size_t word = currentLine.find_first_not_of(" \t", i + 1);
+
+        if(word != std::string::npos
+            && (currentLine.compare(word, 6, "region")    == 0
+                || currentLine.compare(word, 9, "endregion") == 0
+                || currentLine.compare(word, 5, "error")     == 0
+                || currentLine.compare(word, 7, "warning")   == 0))
+        {
+          isInLineCommentNow = true;
+        }
+      }
+      else if(isCStyle() && isExecSQL(currentLine, i))
+      {
+        isInSQLNow = true;
+      }
     }
 
-    std::size_t indent = getIndentLength();
-    std::size_t numSpaces = indent - ((tabIncrementIn + charNum) % indent);
-    currentLine.replace(charNum, 1, numSpaces, ' ');
+    currentLine.swap(tabExpansion);
     currentChar = currentLine[charNum];
   }
 
@@ -4386,7 +4500,7 @@ namespace astyle
   {
     assert(currentChar == '#');
 
-    const std::int32_t preproc = charNum + 1;
+    const std::int64_t preproc = charNum + 1;
 
     if(currentLine.compare(preproc, 2, "if") == 0)
     {
@@ -4483,7 +4597,7 @@ namespace astyle
     else if(bracketFormatMode == NONE_MODE)
     {
       if(currentLineBeginsWithBracket
-          && (std::int32_t)currentLineFirstBracketNum == charNum)    // lineBeginsWith('{')
+          && (std::int64_t)currentLineFirstBracketNum == charNum)    // lineBeginsWith('{')
       {
         breakBracket = true;
       }
@@ -4583,13 +4697,21 @@ namespace astyle
 
       // append the comment up to the next tab or comment end
       // tabs must be checked for convert-tabs before appending
-      while(charNum + 1 < (std::int32_t) currentLine.length()
-            && currentLine[charNum + 1] != '\t'
-            && currentLine.compare(charNum + 1, 2, "*/") != 0)
+      std::size_t commentEnd = currentLine.find_first_of("\t*", charNum + 1);
+
+      while(commentEnd != std::string::npos
+            && currentLine[commentEnd] == '*'
+            && currentLine.compare(commentEnd, 2, "*/") != 0)
       {
-        currentChar = currentLine[++charNum];
-        appendCurrentChar();
+        commentEnd = currentLine.find_first_of("\t*", commentEnd + 1);
+      }
+
+      if(commentEnd == std::string::npos)
+      {
+        commentEnd = currentLine.length();
       }
+
+      appendCharsTo(commentEnd);
     }
   }
 
@@ -4685,15 +4807,17 @@ namespace astyle
 
     // append the comment up to the next tab
     // tabs must be checked for convert-tabs before appending
-    while(charNum + 1 < (std::int32_t) currentLine.length()
-          && currentLine[charNum + 1] != '\t')
+    std::size_t commentEnd = currentLine.find('\t', charNum + 1);
+
+    if(commentEnd == std::string::npos)
     {
-      currentChar = currentLine[++charNum];
-      appendCurrentChar();
+      commentEnd = currentLine.length();
     }
 
+    appendCharsTo(commentEnd);
+
     // explicitely break a line when a line comment's end is found.
-    if(charNum + 1 == (std::int32_t) currentLine.length())
+    if(charNum + 1 == (std::int64_t) currentLine.length())
     {
       isInLineBreak = true;
       isInLineComment = false;
@@ -4711,7 +4835,7 @@ namespace astyle
   {
     assert(isSequenceReached("//"));
 
-    if((std::int32_t)currentLine.length() > charNum + 2
+    if((std::int64_t)currentLine.length() > charNum + 2
         && currentLine[charNum + 2] == '\xf2')     // check for windows line marker
     {
       isAppendPostBlockEmptyLineRequested = false;
@@ -4813,7 +4937,7 @@ namespace astyle
     // if tabbed input don't convert the immediately following tabs to spaces
     if(getIndentString() == "\t" && lineCommentNoIndent)
     {
-      while(charNum + 1 < (std::int32_t) currentLine.length()
+      while(charNum + 1 < (std::int64_t) currentLine.length()
             && currentLine[charNum + 1] == '\t')
       {
         currentChar = currentLine[++charNum];
@@ -4822,7 +4946,7 @@ namespace astyle
     }
 
     // explicitely break a line when a line comment's end is found.
-    if(charNum + 1 == (std::int32_t) currentLine.length())
+    if(charNum + 1 == (std::int64_t) currentLine.length())
     {
       isInLineBreak = true;
       isInLineComment = false;
@@ -4879,13 +5003,15 @@ namespace astyle
     // tabs in quotes are NOT changed by convert-tabs
     if(isInQuote && currentChar != '\\')
     {
-      while(charNum + 1 < (std::int32_t) currentLine.length()
-            && currentLine[charNum + 1] != quoteChar
-            && currentLine[charNum + 1] != '\\')
+      const char quoteEndChars[] = { quoteChar, '\\' };
+      std::size_t quoteEnd = currentLine.find_first_of(quoteEndChars, charNum + 1, 2);
+
+      if(quoteEnd == std::string::npos)
       {
-        currentChar = currentLine[++charNum];
-        appendCurrentChar();
+        quoteEnd = currentLine.length();
       }
+
+      appendCharsTo(quoteEnd);
     }
   }
 
@@ -4950,7 +5076,7 @@ namespace astyle
    * the bracket must be on the same line as the closing header.
    * i.e "} else" changed to "} \n else".
    */
-  std::int32_t ASFormatter::getNextLineCommentAdjustment()
+  std::int64_t ASFormatter::getNextLineCommentAdjustment()
   {
     assert(foundClosingHeader && previousNonWSChar == '}');
 
@@ -4963,7 +5089,7 @@ namespace astyle
 
     if(lastBracket != std::string::npos)
     {
-      return (lastBracket - charNum);  // return a negative number
+      return (static_cast<std::int64_t>(lastBracket) - charNum);  // return a negative number
     }
 
     return 0;
@@ -4982,7 +5108,7 @@ namespace astyle
    * the adjustment is 2 chars, one for the bracket and one for the space.
    * i.e "} \n else" changed to "} else".
    */
-  std::int32_t ASFormatter::getCurrentLineCommentAdjustment()
+  std::int64_t ASFormatter::getCurrentLineCommentAdjustment()
   {
     assert(foundClosingHeader && previousNonWSChar == '}');
 
@@ -5007,7 +5133,7 @@ namespace astyle
    *
    * @return is the previous word or an empty std::string if none found.
    */
-  std::string ASFormatter::getPreviousWord(const std::string& line, std::int32_t currPos) const
+  std::string ASFormatter::getPreviousWord(const std::string& line, std::int64_t currPos) const
   {
     // get the last legal word (may be a number)
     if(currPos == 0)
@@ -5022,7 +5148,7 @@ namespace astyle
       return std::string();
     }
 
-    std::int32_t start;          // start of the previous word
+    std::int64_t start;          // start of the previous word
 
     for(start = end; start > -1; start--)
     {
@@ -5175,7 +5301,7 @@ namespace astyle
 
     // add opening bracket
     currentLine.insert(charNum, "{ ");
-    assert(computeChecksumIn("{}"));
+    computeChecksumIn("{}");
     currentChar = '{';
 
     // remove extra spaces
@@ -5200,7 +5326,7 @@ namespace astyle
    * @param searchStart  the start position on the line (default is 0).
    * @return the position on the line or std::string::npos if not found.
    */
-  std::size_t ASFormatter::findNextChar(std::string& line, char searchChar, std::int32_t searchStart /*0*/)
+  std::size_t ASFormatter::findNextChar(std::string& line, char searchChar, std::int64_t searchStart /*0*/)
   {
     // find the next searchChar
     std::size_t i;
@@ -5400,8 +5526,7 @@ namespace astyle
             return true;
           }
 
-          std::string name = getCurrentWord(nextLine_, i);
-          i += name.length() - 1;
+          i = getWordEnd(nextLine_, i) - 1;
         }
       }  // end of for loop
     }  // end of while loop
@@ -5509,7 +5634,7 @@ namespace astyle
         }
       }
 
-      if((std::int32_t) continuationIncrementIn == tabIncrementIn)
+      if((std::int64_t) continuationIncrementIn == tabIncrementIn)
       {
         charNum = i;
       }
@@ -5517,9 +5642,9 @@ namespace astyle
       {
         // build a new line with the equivalent leading chars
         std::string newLine;
-        std::int32_t leadingChars = 0;
+        std::int64_t leadingChars = 0;
 
-        if((std::int32_t) leadingSpaces > tabIncrementIn)
+        if((std::int64_t) leadingSpaces > tabIncrementIn)
         {
           leadingChars = leadingSpaces - tabIncrementIn;
         }
@@ -5674,17 +5799,23 @@ namespace astyle
 
   /**
    * Compute the input checksum.
-   * This is called as an assert so it for is debug config only
+   * The checksum is the sum of the non-whitespace characters, so it
+   * does not change when brackets or pointers are moved.
+   * The loop has no branches and a 32 bit sum so the compiler can vectorize it.
+   * getChecksumDiff compares the 32 bit difference.
    */
-  bool ASFormatter::computeChecksumIn(const std::string& currentLine_)
+  void ASFormatter::computeChecksumIn(const std::string& currentLine_)
   {
-    for(std::size_t i = 0; i < currentLine_.length(); i++)
-      if(!isWhiteSpace(currentLine_[i]))
-      {
-        checksumIn += currentLine_[i];
-      }
+    const char* data = currentLine_.data();
+    std::size_t len = currentLine_.length();
+    std::uint32_t sum = 0;
 
-    return true;
+    for(std::size_t i = 0; i < len; i++)
+    {
+      sum += (data[i] != ' ' && data[i] != '\t') ? data[i] : 0;
+    }
+
+    checksumIn += sum;
   }
 
   /**
@@ -5699,17 +5830,20 @@ namespace astyle
 
   /**
    * Compute the output checksum.
-   * This is called as an assert so it is for debug config only
+   * It must equal the input checksum when the file is finished.
    */
-  bool ASFormatter::computeChecksumOut(const std::string& beautifiedLine)
+  void ASFormatter::computeChecksumOut(const std::string& beautifiedLine)
   {
-    for(std::size_t i = 0; i < beautifiedLine.length(); i++)
-      if(!isWhiteSpace(beautifiedLine[i]))
-      {
-        checksumOut += beautifiedLine[i];
-      }
+    const char* data = beautifiedLine.data();
+    std::size_t len = beautifiedLine.length();
+    std::uint32_t sum = 0;
 
-    return true;
+    for(std::size_t i = 0; i < len; i++)
+    {
+      sum += (data[i] != ' ' && data[i] != '\t') ? data[i] : 0;
+    }
+
+    checksumOut += sum;
   }
 
   /**
@@ -235,8 +235,7 @@ namespace astyle
 // Call the settext class and return the value.
   {
     assert(m_translation);
-    const std::string stringIn = textIn;
-    return m_translation->translate(stringIn).c_str();
+    return m_translation->translate(textIn);
   }
 
   void ASLocalizer::setTranslationClass()
@@ -245,6 +244,7 @@ namespace astyle
 // Get the language ID at http://msdn.microsoft.com/en-us/library/ee797784%28v=cs.20%29.aspx
   {
     assert(m_langID.length());
+    delete m_translation;
 
     if(m_langID == "zh" && m_subLangID == "CHS")
     {
@@ -278,6 +278,9 @@ namespace astyle
     {
       m_translation = new English;
     }
+
+    // convert the translations for the current locale
+    m_translation->buildCatalog();
   }
 
 //----------------------------------------------------------------------------
@@ -291,43 +294,50 @@ namespace astyle
     m_translation.push_back(entry);
   }
 
-  std::string Translation::convertToMultiByte(const std::wstring& wideStr) const
-// Convert wchar_t to a multibyte std::string using the currently assigned locale.
-// Return an empty std::string if an error occurs.
+  void Translation::buildCatalog()
+// Convert the translation std::vector to multibyte using the currently assigned locale.
+// This is done once so translate() does not need to convert or to search the std::vector.
   {
-    static bool msgDisplayed = false;
-    // get length of the output excluding the nullptr and validate the parameters
-    std::size_t mbLen = wcstombs(nullptr, wideStr.c_str(), 0);
+    bool msgDisplayed = false;
+    m_catalog.clear();
+    m_catalog.reserve(m_translation.size());
 
-    if(mbLen == std::string::npos)
+    for(std::size_t i = 0; i < m_translation.size(); i++)
     {
-      if(!msgDisplayed)
+      std::string mbTranslation = convertToMultiByte(m_translation[i].second);
+
+      // not converted, the english will be used
+      if(mbTranslation.empty())
       {
-        fprintf(stderr, "\n%s\n\n", "Cannot convert to multi-byte std::string, reverting to English");
-        msgDisplayed = true;
+        if(!msgDisplayed && !m_translation[i].second.empty())
+        {
+          fprintf(stderr, "\n%s\n\n", "Cannot convert to multi-byte std::string, reverting to English");
+          msgDisplayed = true;
+        }
+
+        continue;
       }
 
-      return "";
+      m_catalog.emplace(m_translation[i].first, mbTranslation);
     }
+  }
 
-    // convert the characters
-    char* mbStr = new(std::nothrow) char[mbLen + 1];
+  std::string Translation::convertToMultiByte(const std::wstring& wideStr) const
+// Convert wchar_t to a multibyte std::string using the currently assigned locale.
+// Return an empty std::string if an error occurs.
+  {
+    // get length of the output excluding the nullptr and validate the parameters
+    std::size_t mbLen = wcstombs(nullptr, wideStr.c_str(), 0);
 
-    if(mbStr == nullptr)
+    if(mbLen == std::string::npos)
     {
-      if(!msgDisplayed)
-      {
-        fprintf(stderr, "\n%s\n\n", "Bad memory alloc for multi-byte std::string, reverting to English");
-        msgDisplayed = true;
-      }
-
       return "";
     }
 
-    wcstombs(mbStr, wideStr.c_str(), mbLen + 1);
-    // return the std::string
-    std::string mbTranslation = mbStr;
-    delete [] mbStr;
+    // convert the characters
+    std::string mbTranslation(mbLen + 1, '\0');
+    wcstombs(&mbTranslation[0], wideStr.c_str(), mbLen + 1);
+    mbTranslation.resize(mbLen);
     return mbTranslation;
   }
 
@@ -356,30 +366,20 @@ namespace astyle
     return false;
   }
 
-  std::string& Translation::translate(const std::string& stringIn) const
+  const char* Translation::translate(const char* stringIn) const
 // Translate a std::string.
-// Return a static std::string instead of a member variable so the method can have a "const" designation.
-// This allows "settext" to be called from a "const" method.
+// The translation is found in the catalog built by buildCatalog().
+// The catalog is not changed, so this may be called from a "const" method or by multiple threads.
   {
-    static std::string mbTranslation;
-    mbTranslation.clear();
-
-    for(std::size_t i = 0; i < m_translation.size(); i++)
-    {
-      if(m_translation[i].first == stringIn)
-      {
-        mbTranslation = convertToMultiByte(m_translation[i].second);
-        break;
-      }
-    }
+    std::unordered_map<std::string_view, std::string>::const_iterator entry = m_catalog.find(stringIn);
 
     // not found, return english
-    if(mbTranslation.empty())
+    if(entry == m_catalog.end())
     {
-      mbTranslation = stringIn;
+      return stringIn;
     }
 
-    return mbTranslation;
+    return entry->second.c_str();
   }
 
 //----------------------------------------------------------------------------
@@ -28,6 +28,9 @@
 #ifndef ASLOCALIZER_H
 #define ASLOCALIZER_H
 
+#include <string_view>
+#include <unordered_map>
+
 namespace astyle
 {
 
@@ -77,10 +80,12 @@ namespace astyle
   {
   public:
     Translation() {};
+    virtual ~Translation() {}
+    void buildCatalog();
     std::string convertToMultiByte(const std::wstring& wideStr) const;
     std::size_t getTranslationVectorSize() const;
     bool getWideTranslation(const std::string& stringIn, std::wstring& wideOut) const;
-    std::string& translate(const std::string& stringIn) const;
+    const char* translate(const char* stringIn) const;
 
   protected:
     void addPair(const std::string& english, const std::wstring& translated);
@@ -88,6 +93,9 @@ namespace astyle
     std::vector<std::pair<std::string, std::wstring> > m_translation;    // translation std::vector
 
   private:
+    // multi-byte translations indexed by the english std::string in m_translation
+    std::unordered_map<std::string_view, std::string> m_catalog;
+
     // unused method so the class will be identified as polymorphic
     virtual void virtualClass() {}
   };
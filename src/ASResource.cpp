@@ -179,6 +179,18 @@ namespace astyle
     return *a < *b;
   }
 
+  /**
+   * Search comparison function.
+   * Compares the value of a pointer in a std::vector sorted by sortOnName
+   * with a word on the line being processed.
+   *
+   * @params the std::string pointer and the word to be compared.
+   */
+  bool searchOnName(const std::string* a, std::string_view b)
+  {
+    return std::string_view(*a) < b;
+  }
+
   /**
    * Build the std::vector of assignment operators.
    * Used by BOTH ASFormatter.cpp and ASBeautifier.cpp
@@ -220,6 +232,8 @@ namespace astyle
     castOperators->push_back(&AS_DYNAMIC_CAST);
     castOperators->push_back(&AS_REINTERPRET_CAST);
     castOperators->push_back(&AS_STATIC_CAST);
+
+    sort(castOperators->begin(), castOperators->end(), sortOnName);
   }
 
   /**
@@ -536,14 +550,15 @@ namespace astyle
    * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 // check if a specific line position contains a keyword.
-  bool ASBase::findKeyword(const std::string& line, std::int32_t i, const std::string& keyword) const
+  bool ASBase::findKeyword(const std::string& line, std::int64_t i, const std::string& keyword) const
   {
     assert(isCharPotentialHeader(line, i));
     // check the word
     const std::size_t keywordLength = keyword.length();
     const std::size_t wordEnd = i + keywordLength;
 
-    if(wordEnd > line.length())
+    if(wordEnd > line.length()
+        || line[i] != keyword[0])
     {
       return false;
     }
@@ -580,6 +595,14 @@ namespace astyle
   std::string ASBase::getCurrentWord(const std::string& line, std::size_t index) const
   {
     assert(isCharPotentialHeader(line, index));
+    return line.substr(index, getWordEnd(line, index) - index);
+  }
+
+// get the end of the current word on a line
+// index must point to the beginning of the word
+// the word is scanned only once and may then be classified without copying it
+  std::size_t ASBase::getWordEnd(const std::string& line, std::size_t index) const
+  {
     std::size_t lineLength = line.length();
     std::size_t i;
 
@@ -591,7 +614,7 @@ namespace astyle
       }
     }
 
-    return line.substr(index, i - index);
+    return i;
   }
 
 }   // end namespace astyle
@@ -37,8 +37,14 @@
 
 #include <string.h>         // need both std::string and std::string.h for GCC
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <cctype>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
 
 #ifdef _WIN32
 #define STDCALL __stdcall
@@ -164,6 +170,50 @@ namespace astyle
     virtual void peekReset() = 0;
   };
 
+//-----------------------------------------------------------------------------
+// Class ASStackArena
+// The state stacks of ASBeautifier and ASFormatter are allocated from this
+// arena instead of the heap. It is owned by the original beautifier and is
+// shared by the cloned beautifiers used for preprocessor statements.
+// The first block of memory is inline storage that is large enough for the
+// stacks of a typical file. The stacks are cleared and reused for each new
+// file, so the capacity is kept for the whole job.
+//-----------------------------------------------------------------------------
+
+  template<typename T> using ASStack = std::pmr::vector<T>;
+
+  class ASStackArena
+  {
+  public:
+    ASStackArena()
+      : monotonic(inlineBuffer, sizeof(inlineBuffer)), pool(&monotonic) {}
+
+    // create an empty stack with room for the typical depth
+    template<typename T> T* newStack()
+    {
+      void* memory = pool.allocate(sizeof(T), alignof(T));
+      T* stack = new(memory) T(&pool);
+      stack->reserve(STACK_RESERVE);
+      return stack;
+    }
+
+    // destroy a stack created by newStack()
+    template<typename T> void deleteStack(T* stack)
+    {
+      stack->~T();
+      pool.deallocate(stack, sizeof(T), alignof(T));
+    }
+
+  private:
+    ASStackArena(const ASStackArena& copy);       // copy constructor not to be implemented
+    ASStackArena& operator=(ASStackArena&);       // assignment operator not to be implemented
+
+    enum { INLINE_SIZE = 16384, STACK_RESERVE = 16 };
+    alignas(std::max_align_t) char inlineBuffer[INLINE_SIZE];
+    std::pmr::monotonic_buffer_resource monotonic;  // the arena, starting with inlineBuffer
+    std::pmr::unsynchronized_pool_resource pool;    // recycles stacks of deleted clones
+  };
+
 //-----------------------------------------------------------------------------
 // Class ASResource
 //-----------------------------------------------------------------------------
@@ -220,6 +270,53 @@ namespace astyle
     static const std::string AS_CONST_CAST, AS_DYNAMIC_CAST, AS_REINTERPRET_CAST, AS_STATIC_CAST;
   };  // Class ASResource
 
+//-----------------------------------------------------------------------------
+// Character class tables
+// A table is built at compile time for each file type.
+// They replace the locale dependent isalnum() and ispunct() in the
+// character tests of ASBase and have no file type tests.
+//-----------------------------------------------------------------------------
+
+  enum CharClass     { NAME_CHAR = 1,             // can be used in a name
+                       OPERATOR_CHAR = 2          // can be part of an operator
+                     };
+
+  constexpr std::array<std::uint8_t, 256> buildCharClassTable(std::int32_t fileType)
+  {
+    std::array<std::uint8_t, 256> table {};
+
+    for(std::size_t ch = 0; ch < 128; ch++)
+    {
+      bool isAlnum = (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+      bool isPunct = (ch > ' ' && ch < 127 && !isAlnum);
+
+      if(isAlnum
+          || ch == '.' || ch == '_'
+          || (fileType == JAVA_TYPE && ch == '$')
+          || (fileType == SHARP_TYPE && ch == '@'))   // may be used as a prefix
+      {
+        table[ch] |= NAME_CHAR;
+      }
+
+      if(isPunct
+          && ch != '{' && ch != '}'
+          && ch != '(' && ch != ')'
+          && ch != '[' && ch != ']'
+          && ch != ';' && ch != ','
+          && ch != '#' && ch != '\\'
+          && ch != '\'' && ch != '\"')
+      {
+        table[ch] |= OPERATOR_CHAR;
+      }
+    }
+
+    return table;
+  }
+
+  inline constexpr std::array<std::uint8_t, 256> C_CHAR_CLASS = buildCharClassTable(C_TYPE);
+  inline constexpr std::array<std::uint8_t, 256> JAVA_CHAR_CLASS = buildCharClassTable(JAVA_TYPE);
+  inline constexpr std::array<std::uint8_t, 256> SHARP_CHAR_CLASS = buildCharClassTable(SHARP_TYPE);
+
 //-----------------------------------------------------------------------------
 // Class ASBase
 //-----------------------------------------------------------------------------
@@ -229,20 +326,35 @@ namespace astyle
   private:
     // all variables should be set by the "init" function
     std::int32_t baseFileType;      // a value from enum FileType
+    const std::uint8_t* charClass;  // the character class table for the file type
 
   protected:
-    ASBase() : baseFileType(C_TYPE) { }
+    ASBase() : baseFileType(C_TYPE), charClass(C_CHAR_CLASS.data()) { }
     virtual ~ASBase() {}
 
     // functions definitions are at the end of ASResource.cpp
-    bool findKeyword(const std::string& line, std::int32_t i, const std::string& keyword) const;
+    bool findKeyword(const std::string& line, std::int64_t i, const std::string& keyword) const;
     std::string getCurrentWord(const std::string& line, std::size_t index) const;
+    std::size_t getWordEnd(const std::string& line, std::size_t index) const;
 
   protected:
 
     void init(std::int32_t fileTypeArg)
     {
       baseFileType = fileTypeArg;
+
+      if(fileTypeArg == JAVA_TYPE)
+      {
+        charClass = JAVA_CHAR_CLASS.data();
+      }
+      else if(fileTypeArg == SHARP_TYPE)
+      {
+        charClass = SHARP_CHAR_CLASS.data();
+      }
+      else
+      {
+        charClass = C_CHAR_CLASS.data();
+      }
     }
     bool isCStyle() const
     {
@@ -267,20 +379,7 @@ namespace astyle
     // check if a specific character can be used in a legal variable/method/class name
     bool isLegalNameChar(char ch) const
     {
-      if(isWhiteSpace(ch))
-      {
-        return false;
-      }
-
-      if((unsigned) ch > 127)
-      {
-        return false;
-      }
-
-      return (isalnum(ch)
-              || ch == '.' || ch == '_'
-              || (isJavaStyle() && ch == '$')
-              || (isSharpStyle() && ch == '@'));  // may be used as a prefix
+      return (charClass[(unsigned char) ch] & NAME_CHAR) != 0;
     }
 
     // check if a specific character can be part of a header
@@ -306,19 +405,7 @@ namespace astyle
     bool isCharPotentialOperator(char ch) const
     {
       assert(!isWhiteSpace(ch));
-
-      if((unsigned) ch > 127)
-      {
-        return false;
-      }
-
-      return (ispunct(ch)
-              && ch != '{' && ch != '}'
-              && ch != '(' && ch != ')'
-              && ch != '[' && ch != ']'
-              && ch != ';' && ch != ','
-              && ch != '#' && ch != '\\'
-              && ch != '\'' && ch != '\"');
+      return (charClass[(unsigned char) ch] & OPERATOR_CHAR) != 0;
     }
 
     // check if a specific character is a whitespace character
@@ -328,7 +415,7 @@ namespace astyle
     }
 
     // peek at the next unread character.
-    char peekNextChar(const std::string& line, std::int32_t i) const
+    char peekNextChar(const std::string& line, std::int64_t i) const
     {
       char ch = ' ';
       std::size_t peekNum = line.find_first_not_of(" \t", i + 1);
@@ -355,6 +442,7 @@ namespace astyle
     virtual void init(ASSourceIterator* iter);
     void init();
     virtual std::string beautify(const std::string& line);
+    void beautify(const std::string& originalLine, std::string& outBuffer);
     void setTabIndentation(std::int32_t length = 4, bool forceTabs = false);
     void setSpaceIndentation(std::int32_t length = 4);
     void setMaxInStatementIndentLength(std::int32_t max);
@@ -388,12 +476,12 @@ namespace astyle
 
   protected:
     void deleteBeautifierVectors();
-    const std::string* findHeader(const std::string& line, std::int32_t i,
+    const std::string* findHeader(const std::string& line, std::int64_t i,
                                   const std::vector<const std::string*>* possibleHeaders) const;
-    const std::string* findOperator(const std::string& line, std::int32_t i,
+    const std::string* findOperator(const std::string& line, std::int64_t i,
                                     const std::vector<const std::string*>* possibleOperators) const;
-    std::int32_t getNextProgramCharDistance(const std::string& line, std::int32_t i) const;
-    std::int32_t  indexOf(std::vector<const std::string*> &container, const std::string* element);
+    std::int64_t getNextProgramCharDistance(const std::string& line, std::int64_t i) const;
+    template<typename T> std::int32_t indexOf(T& container, const std::string* element);
     void setBlockIndent(bool state);
     void setBracketIndent(bool state);
     std::string trim(const std::string& str);
@@ -410,32 +498,64 @@ namespace astyle
     bool isInBeautifySQL;
     bool isInIndentableStruct;
 
+    // arena for the state stacks, shared with the cloned beautifiers
+    ASStackArena* stackArena;
+
   private:
     ASBeautifier(const ASBeautifier& copy);
     ASBeautifier& operator=(ASBeautifier&);        // not to be implemented
 
+    // the state of a statement scan by statementEndsWithComma()
+    struct CommaScan
+    {
+      CommaScan() : pos(0), parenCount(0), isInComment(false), isInQuote(false),
+        isEnded(false), quoteChar(' ') {}
+      std::size_t pos;
+      std::int32_t parenCount;
+      bool isInComment;
+      bool isInQuote;
+      bool isEnded;                     // stopped at a comment that ends the line
+      char quoteChar;
+    };
+
     void computePreliminaryIndentation();
     void parseCurrentLine(const std::string& line);
     void processProcessor(std::string& line);
-    void registerInStatementIndent(const std::string& line, std::int32_t i, std::int32_t spaceTabCount,
-                                   std::int32_t tabIncrementIn, std::int32_t minIndent, bool updateParenStack);
+    void registerInStatementIndent(const std::string& line, std::int64_t i, std::int32_t spaceTabCount,
+                                   std::int64_t tabIncrementIn, std::int32_t minIndent, bool updateParenStack);
     void initVectors();
-    std::string preLineWS(std::int32_t spaceTabCount_, std::int32_t tabCount_);
-    std::int32_t  convertTabToSpaces(std::int32_t i, std::int32_t tabIncrementIn) const;
-    std::int32_t  getInStatementIndentAssign(const std::string& line, std::size_t currPos) const;
-    std::int32_t  getInStatementIndentComma(const std::string& line, std::size_t currPos) const;
+    void preLineWS(std::string& outBuffer, std::int32_t spaceTabCount_, std::int32_t tabCount_) const;
+    std::int32_t  clampIndent(std::int64_t indent) const;
+    std::int32_t  convertTabToSpaces(std::int64_t i, std::int64_t tabIncrementIn) const;
+    std::int64_t  getInStatementIndentAssign(const std::string& line, std::size_t currPos) const;
+    std::int64_t  getInStatementIndentComma(const std::string& line, std::size_t currPos) const;
     bool isClassAccessModifier(const std::string& line) const;
     bool isIndentedPreprocessor(const std::string& line, std::size_t currPos) const;
-    bool isLineEndComment(const std::string& line, std::int32_t startPos) const;
-    bool statementEndsWithComma(const std::string& line, std::int32_t index) const;
-    std::vector<std::vector<const std::string*>*>* copyTempStacks(const ASBeautifier& other) const;
-    template<typename T> void deleteContainer(T& container);
-    void deleteContainer(std::vector<std::vector<const std::string*>*>* &container);
-    template<typename T> void initContainer(T& container, T value);
+    bool isLineEndComment(const std::string& line, std::int64_t startPos) const;
+    bool statementEndsWithComma(const std::string& line, std::int64_t index);
+    void scanStatementEnd(const std::string& line, CommaScan& scan, std::size_t stop) const;
+    ASStack<ASStack<const std::string*>*>* copyTempStacks(const ASBeautifier& other) const;
+    void deleteBeautifierContainers();
+    template<typename T> void clearContainer(ASStack<T>* container);
+    void clearContainer(ASStack<ASBeautifier*>* container);
+    void clearContainer(ASStack<ASStack<const std::string*>*>* container);
+    template<typename T> void deleteContainer(ASStack<T>* &container);
+    template<typename T> void initContainer(ASStack<T>* &container);
 
   private:  // variables
 
+    // the language vectors for one file type
+    struct BeautifierVectors
+    {
+      std::vector<const std::string*> headers;
+      std::vector<const std::string*> nonParenHeaders;
+      std::vector<const std::string*> preBlockStatements;
+      std::vector<const std::string*> preCommandHeaders;
+    };
+
     std::int32_t beautifierFileType;
+    bool isStackArenaOwner;                 // false for a cloned beautifier
+    BeautifierVectors* beautifierVectors[SHARP_TYPE + 1];  // built once for each file type
     std::vector<const std::string*>* headers;
     std::vector<const std::string*>* nonParenHeaders;
     std::vector<const std::string*>* preBlockStatements;
@@ -444,19 +564,19 @@ namespace astyle
     std::vector<const std::string*>* nonAssignmentOperators;
     std::vector<const std::string*>* indentableHeaders;
 
-    std::vector<ASBeautifier*> *waitingBeautifierStack;
-    std::vector<ASBeautifier*> *activeBeautifierStack;
-    std::vector<std::int32_t> *waitingBeautifierStackLengthStack;
-    std::vector<std::int32_t> *activeBeautifierStackLengthStack;
-    std::vector<const std::string*> *headerStack;
-    std::vector< std::vector<const std::string*>* > *tempStacks;
-    std::vector<std::int32_t> *blockParenDepthStack;
-    std::vector<bool> *blockStatementStack;
-    std::vector<bool> *parenStatementStack;
-    std::vector<bool> *bracketBlockStateStack;
-    std::vector<std::int32_t> *inStatementIndentStack;
-    std::vector<std::int32_t> *inStatementIndentStackSizeStack;
-    std::vector<std::int32_t> *parenIndentStack;
+    ASStack<ASBeautifier*> *waitingBeautifierStack;
+    ASStack<ASBeautifier*> *activeBeautifierStack;
+    ASStack<std::int32_t> *waitingBeautifierStackLengthStack;
+    ASStack<std::int32_t> *activeBeautifierStackLengthStack;
+    ASStack<const std::string*> *headerStack;
+    ASStack< ASStack<const std::string*>* > *tempStacks;
+    ASStack<std::int32_t> *blockParenDepthStack;
+    ASStack<bool> *blockStatementStack;
+    ASStack<bool> *parenStatementStack;
+    ASStack<bool> *bracketBlockStateStack;
+    ASStack<std::int32_t> *inStatementIndentStack;
+    ASStack<std::int32_t> *inStatementIndentStackSizeStack;
+    ASStack<std::int32_t> *parenIndentStack;
 
     ASSourceIterator* sourceIterator;
     const std::string* currentHeader;
@@ -464,6 +584,9 @@ namespace astyle
     const std::string* probationHeader;
     const std::string* lastLineHeader;
     std::string indentString;
+    std::string lineBuffer;                 // reused by beautify() for each line
+    CommaScan commaScan;                    // the last scan by statementEndsWithComma()
+    std::int64_t commaScanIndex;            // the assignment of commaScan, -1 if none
     bool isInQuote;
     bool isInVerbatimQuote;
     bool haveLineContinuationChar;
@@ -587,7 +710,7 @@ namespace astyle
     std::int32_t     indentLine(std::string&  line, std::int32_t indent) const;
     bool    isBeginDeclareSectionSQL(std::string&  line, std::size_t index) const;
     bool    isEndDeclareSectionSQL(std::string&  line, std::size_t index) const;
-    bool    isOneLineBlockReached(std::string& line, std::int32_t startChar) const;
+    bool    isOneLineBlockReached(std::string& line, std::int64_t startChar) const;
     std::size_t  processSwitchBlock(std::string&  line, std::size_t index);
     std::int32_t     unindentLine(std::string&  line, std::int32_t unindent) const;
   };  // Class ASEnhancer
@@ -604,6 +727,7 @@ namespace astyle
     virtual void init(ASSourceIterator* iter);
     virtual bool hasMoreLines() const;
     virtual std::string nextLine();
+    void nextLine(std::string& outBuffer);
     LineEndFormat getLineEndFormat() const;
     bool getIsLineReady() const;
     void setFormattingStyle(FormatStyle style);
@@ -635,8 +759,8 @@ namespace astyle
   private:  // functions
     ASFormatter(const ASFormatter& copy);       // copy constructor not to be imlpemented
     ASFormatter& operator=(ASFormatter&);       // assignment operator not to be implemented
-    template<typename T> void deleteContainer(T& container);
-    template<typename T> void initContainer(T& container, T value);
+    template<typename T> void deleteContainer(ASStack<T>* &container);
+    template<typename T> void initContainer(ASStack<T>* &container);
     char peekNextChar() const;
     BracketType getBracketType();
     bool addBracketsToStatement();
@@ -645,15 +769,15 @@ namespace astyle
     bool getNextLine(bool emptyLineWasDeleted = false);
     bool isBeforeComment() const;
     bool isBeforeAnyComment() const;
-    bool isBeforeAnyLineEndComment(std::int32_t startPos) const;
-    bool isBeforeMultipleLineEndComments(std::int32_t startPos) const;
+    bool isBeforeAnyLineEndComment(std::int64_t startPos) const;
+    bool isBeforeMultipleLineEndComments(std::int64_t startPos) const;
     bool isBracketType(BracketType a, BracketType b) const;
     bool isClosingHeader(const std::string* header) const;
     bool isCurrentBracketBroken() const;
     bool isDereferenceOrAddressOf() const;
     bool isExecSQL(std::string&  line, std::size_t index) const;
     bool isEmptyLine(const std::string& line) const;
-    bool isNextWordSharpNonParenHeader(std::int32_t startChar) const;
+    bool isNextWordSharpNonParenHeader(std::int64_t startChar) const;
     bool isNonInStatementArrayBracket() const;
     bool isPointerOrReference() const;
     bool isPointerOrReferenceCentered() const;
@@ -662,11 +786,11 @@ namespace astyle
     bool isUnaryOperator() const;
     bool isImmediatelyPostCast() const;
     bool isInExponent() const;
-    bool isNextCharOpeningBracket(std::int32_t startChar) const;
+    bool isNextCharOpeningBracket(std::int64_t startChar) const;
     bool isOkToBreakBlock(BracketType bracketType) const;
-    std::int32_t  getCurrentLineCommentAdjustment();
-    std::int32_t  getNextLineCommentAdjustment();
-    std::int32_t  isOneLineBlockReached(std::string& line, std::int32_t startChar) const;
+    std::int64_t  getCurrentLineCommentAdjustment();
+    std::int64_t  getNextLineCommentAdjustment();
+    std::int32_t  isOneLineBlockReached(std::string& line, std::int64_t startChar) const;
     void adjustComments();
     void appendCharInsideComments();
     void appendSequence(const std::string& sequence, bool canBreakLine = true);
@@ -677,7 +801,6 @@ namespace astyle
     void checkForHeaderFollowingComment(const std::string& firstLine);
     void checkIfTemplateOpener();
     void convertTabToSpaces();
-    void deleteContainer(std::vector<BracketType>* &container);
     void formatArrayRunIn();
     void formatRunIn();
     void formatArrayBrackets(BracketType bracketType, bool isOpeningArrayBracket);
@@ -692,9 +815,8 @@ namespace astyle
     void formatPointerOrReference();
     void formatPointerOrReferenceCast();
     void fixOptionVariableConflicts();
-    void goForward(std::int32_t i);
+    void goForward(std::int64_t i);
     void isLineBreakBeforeClosingHeader();
-    void initContainer(std::vector<BracketType>* &container, std::vector<BracketType>* value);
     void initNewLine();
     void padOperators(const std::string* newOperator);
     void padParens();
@@ -702,12 +824,23 @@ namespace astyle
     void setAttachClosingBracket(bool state);
     void setBreakBlocksVariables();
     void trimContinuationLine();
-    std::size_t findNextChar(std::string& line, char searchChar, std::int32_t searchStart = 0);
-    std::string getPreviousWord(const std::string& line, std::int32_t currPos) const;
+    std::size_t findNextChar(std::string& line, char searchChar, std::int64_t searchStart = 0);
+    std::string getPreviousWord(const std::string& line, std::int64_t currPos) const;
     std::string peekNextText(const std::string& firstLine, bool endOnEmptyLine = false, bool shouldReset = false) const;
 
   private:  // variables
+
+    // the language vectors for one file type
+    struct FormatterVectors
+    {
+      std::vector<const std::string*> headers;
+      std::vector<const std::string*> nonParenHeaders;
+      std::vector<const std::string*> preDefinitionHeaders;
+      std::vector<const std::string*> preCommandHeaders;
+    };
+
     std::int32_t formatterFileType;
+    FormatterVectors* formatterVectors[SHARP_TYPE + 1];    // built once for each file type
     std::vector<const std::string*>* headers;
     std::vector<const std::string*>* nonParenHeaders;
     std::vector<const std::string*>* preDefinitionHeaders;
@@ -719,13 +852,15 @@ namespace astyle
     ASSourceIterator* sourceIterator;
     ASEnhancer* enhancer;
 
-    std::vector<const std::string*> *preBracketHeaderStack;
-    std::vector<BracketType> *bracketTypeStack;
-    std::vector<std::int32_t> *parenStack;
-    std::vector<bool> *structStack;
+    ASStack<const std::string*> *preBracketHeaderStack;
+    ASStack<BracketType> *bracketTypeStack;
+    ASStack<std::int32_t> *parenStack;
+    ASStack<bool> *structStack;
     std::string readyFormattedLine;
     std::string currentLine;
     std::string formattedLine;
+    std::string beautifiedLine;             // reused by nextLine() for each line
+    std::string tabExpansion;               // reused by convertTabToSpaces() for each line
     const std::string* currentHeader;
     const std::string* previousOperator;    // used ONLY by pad-oper
     char currentChar;
@@ -733,12 +868,12 @@ namespace astyle
     char previousNonWSChar;
     char previousCommandChar;
     char quoteChar;
-    std::int32_t  charNum;
+    std::int64_t  charNum;
     std::int32_t  horstmannIndentChars;
-    std::int32_t  nextLineSpacePadNum;
+    std::int64_t  nextLineSpacePadNum;
     std::int32_t  preprocBracketTypeStackSize;
-    std::int32_t  spacePadNum;
-    std::int32_t  tabIncrementIn;
+    std::int64_t  spacePadNum;
+    std::int64_t  tabIncrementIn;
     std::int32_t  templateDepth;
     std::int32_t  traceLineNumber;
     std::size_t checksumIn;
@@ -753,8 +888,8 @@ namespace astyle
     PointerAlign pointerAlignment;
     ReferenceAlign referenceAlignment;
     LineEndFormat lineEnd;
-    bool computeChecksumIn(const std::string& currentLine_);
-    bool computeChecksumOut(const std::string& beautifiedLine);
+    void computeChecksumIn(const std::string& currentLine_);
+    void computeChecksumOut(const std::string& beautifiedLine);
     bool isVirgin;
     bool shouldPadOperators;
     bool shouldPadParensOutside;
@@ -867,10 +1002,27 @@ namespace astyle
       appendChar(currentChar, canBreakLine);
     }
 
+    // append the characters following the current character up to, but not including,
+    // the character at 'end' to the current formatted line.
+    // the last character appended becomes the current character.
+    void appendCharsTo(std::size_t end)
+    {
+      if((std::int64_t) end > charNum + 1)
+      {
+        formattedLine.append(currentLine, charNum + 1, end - charNum - 1);
+        charNum = end - 1;
+        currentChar = currentLine[charNum];
+        isImmediatelyPostCommentOnly = false;
+      }
+    }
+
     // check if a specific sequence exists in the current placement of the current line
+    // the length of a literal sequence is known at compile time so the compare is inlined
     bool isSequenceReached(const char* sequence) const
     {
-      return currentLine.compare(charNum, strlen(sequence), sequence) == 0;
+      const std::size_t sequenceLength = strlen(sequence);
+      return (currentLine.length() - charNum >= sequenceLength
+              && memcmp(currentLine.data() + charNum, sequence, sequenceLength) == 0);
     }
 
     // call ASBase::findHeader for the current character
@@ -893,6 +1045,7 @@ namespace astyle
 // sort comparison functions for ASResource
   bool sortOnLength(const std::string* a, const std::string* b);
   bool sortOnName(const std::string* a, const std::string* b);
+  bool searchOnName(const std::string* a, std::string_view b);
 
 }   // end of astyle namespace
 
@@ -907,6 +1060,7 @@ namespace astyle
 typedef void (STDCALL* fpError)(std::int32_t, const char*);      // pointer to callback error handler
 typedef char* (STDCALL* fpAlloc)(unsigned long);    // pointer to callback memory allocation
 extern "C" EXPORT char* STDCALL AStyleMain(const char*, const char*, fpError, fpAlloc);
+extern "C" EXPORT char* STDCALL AStyleMainEdits(const char*, const char*, fpError, fpAlloc);
 extern "C" EXPORT const char* STDCALL AStyleGetVersion(void);
 
 
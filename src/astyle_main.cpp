@@ -25,12 +25,21 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  */
 
+// use 64-bit file offsets so stat() and the file streams handle files over 2 GB
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include "astyle_main.h"
 
 #include <algorithm>
+#include <map>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <set>
 #include <sstream>
+#include <unordered_map>
 #include <cstdlib>
 #include <errno.h>
 
@@ -38,10 +47,19 @@
 #ifdef _WIN32
 #undef UNICODE    // use ASCII windows functions
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
 #else
 #include <dirent.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 #ifdef __VMS
+#include <fcntl.h>
 #include <unixlib.h>
 #include <rms.h>
 #include <ssdef.h>
@@ -65,24 +83,19 @@ namespace astyle
 {
 
 #ifdef _WIN32
-  char g_fileSeparator = '\\';
-  bool g_isCaseSensitive = false;
+  const char g_fileSeparator = '\\';
+  const bool g_isCaseSensitive = false;
 #else
-  char g_fileSeparator = '/';
-  bool g_isCaseSensitive = true;
-#endif
-
-// console build variables
-#ifndef ASTYLE_LIB
-  std::ostream* _err = &std::cerr;           // direct error messages to cerr
-  ASConsole* g_console = nullptr;     // class to encapsulate console variables
+  const char g_fileSeparator = '/';
+  const bool g_isCaseSensitive = true;
 #endif
 
 #ifdef ASTYLE_JNI
 // java library build variables
-  JNIEnv*   g_env;
-  jobject   g_obj;
-  jmethodID g_mid;
+// these are set for each call and are local to the calling thread
+  thread_local JNIEnv*   g_env;
+  thread_local jobject   g_obj;
+  thread_local jmethodID g_mid;
 #endif
 
   const char* g_version = "2.02";
@@ -142,14 +155,7 @@ namespace astyle
 
     // read the next record
     buffer.clear();
-    char ch;
-    inStream->get(ch);
-
-    while(!inStream->eof() && ch != '\n' && ch != '\r')
-    {
-      buffer.append(1, ch);
-      inStream->get(ch);
-    }
+    std::int32_t ch = readRecord(buffer);
 
     if(inStream->eof())
     {
@@ -224,7 +230,6 @@ namespace astyle
   {
     assert(hasMoreLines());
     std::string nextLine_;
-    char ch;
 
     if(peekStart == 0)
     {
@@ -232,13 +237,7 @@ namespace astyle
     }
 
     // read the next record
-    inStream->get(ch);
-
-    while(!inStream->eof() && ch != '\n' && ch != '\r')
-    {
-      nextLine_.append(1, ch);
-      inStream->get(ch);
-    }
+    std::int32_t ch = readRecord(nextLine_);
 
     if(inStream->eof())
     {
@@ -259,6 +258,29 @@ namespace astyle
     return nextLine_;
   }
 
+// read the characters of a record up to the end of line or the end of the stream.
+// the stream buffer is read directly instead of using istream::get for each character.
+// return the end of line character, or EOF if the end of the stream was reached.
+  template<typename T>
+  std::int32_t ASStreamIterator<T>::readRecord(std::string& record)
+  {
+    std::streambuf* inBuffer = inStream->rdbuf();
+    std::int32_t ch = inBuffer->sbumpc();
+
+    while(ch != EOF && ch != '\n' && ch != '\r')
+    {
+      record.append(1, (char) ch);
+      ch = inBuffer->sbumpc();
+    }
+
+    if(ch == EOF)
+    {
+      inStream->setstate(std::ios::eofbit | std::ios::failbit);
+    }
+
+    return ch;
+  }
+
 // reset current position and EOF for peekNextLine()
   template<typename T>
   void ASStreamIterator<T>::peekReset()
@@ -319,332 +341,2712 @@ namespace astyle
     return lineEndChange;
   }
 
-#ifndef ASTYLE_LIB
 //-----------------------------------------------------------------------------
-// ASConsole class
-// main function will be included only in the console build
+// ASLineDiff class
+// used by both console and library builds
 //-----------------------------------------------------------------------------
 
-// rewrite a stringstream converting the line ends
-  void ASConsole::convertLineEnds(std::ostringstream& out, std::int32_t lineEnd)
+  /**
+   * Find the line edits that change the original text into the new text.
+   * The lines are replaced by ids so equal lines are compared as numbers.
+   * A line that is not in the other text must be changed, so it is marked
+   * and is not compared. This removes most lines changed by formatting.
+   *
+   * @param origText      The original text.
+   * @param newText       The new text.
+   * @param splitAtCR     A CR that is not followed by LF also ends a line.
+   *                      The lines end with LF only otherwise, as in diff and patch.
+   */
+  ASLineDiff::ASLineDiff(std::string_view origText, std::string_view newText, bool splitAtCR)
   {
-    assert(lineEnd == LINEEND_WINDOWS || lineEnd == LINEEND_LINUX || lineEnd == LINEEND_MACOLD);
-    const std::string& inStr = out.str();  // avoids strange looking syntax
-    std::string outStr;            // the converted ouput
-    std::int32_t inLength = inStr.length();
+    isCRLineEnd = splitAtCR;
+    splitLines(origText, origLines);
+    splitLines(newText, newLines);
 
-    for(std::int32_t pos = 0; pos < inLength; pos++)
+    // the equal lines at the beginning and the end are not compared
+    std::size_t origBegin = 0;
+    std::size_t newBegin = 0;
+    std::size_t origEnd = origLines.size();
+    std::size_t newEnd = newLines.size();
+
+    while(origBegin < origEnd && newBegin < newEnd && origLines[origBegin] == newLines[newBegin])
     {
-      if(inStr[pos] == '\r')
-      {
-        if(inStr[pos + 1] == '\n')
-        {
-          // CRLF
-          if(lineEnd == LINEEND_CR)
-          {
-            outStr += inStr[pos];    // Delete the LF
-            pos++;
-            continue;
-          }
-          else if(lineEnd == LINEEND_LF)
-          {
-            outStr += inStr[pos + 1];    // Delete the CR
-            pos++;
-            continue;
-          }
-          else
-          {
-            outStr += inStr[pos];    // Do not change
-            outStr += inStr[pos + 1];
-            pos++;
-            continue;
-          }
-        }
-        else
-        {
-          // CR
-          if(lineEnd == LINEEND_CRLF)
-          {
-            outStr += inStr[pos];    // Insert the CR
-            outStr += '\n';        // Insert the LF
-            continue;
-          }
-          else if(lineEnd == LINEEND_LF)
-          {
-            outStr += '\n';        // Insert the LF
-            continue;
-          }
-          else
-          {
-            outStr += inStr[pos];    // Do not change
-            continue;
-          }
-        }
-      }
-      else if(inStr[pos] == '\n')
-      {
-        // LF
-        if(lineEnd == LINEEND_CRLF)
-        {
-          outStr += '\r';        // Insert the CR
-          outStr += inStr[pos];    // Insert the LF
-          continue;
-        }
-        else if(lineEnd == LINEEND_CR)
-        {
-          outStr += '\r';        // Insert the CR
-          continue;
-        }
-        else
-        {
-          outStr += inStr[pos];    // Do not change
-          continue;
-        }
-      }
-      else
-      {
-        outStr += inStr[pos];    // Write the current char
-      }
+      origBegin++;
+      newBegin++;
     }
 
-    // replace the stream
-    out.str(outStr);
-  }
-
-  void ASConsole::correctMixedLineEnds(std::ostringstream& out)
-  {
-    LineEndFormat lineEndFormat = LINEEND_DEFAULT;
-
-    if(strcmp(outputEOL, "\r\n") == 0)
+    while(origBegin < origEnd && newBegin < newEnd && origLines[origEnd - 1] == newLines[newEnd - 1])
     {
-      lineEndFormat = LINEEND_WINDOWS;
+      origEnd--;
+      newEnd--;
     }
 
-    if(strcmp(outputEOL, "\n") == 0)
+    std::unordered_map<std::string_view, std::size_t> lineIds;
+    lineIds.reserve(origEnd - origBegin + newEnd - newBegin);
+    std::vector<std::size_t> origAllIds(origEnd - origBegin);
+    std::vector<std::size_t> newAllIds(newEnd - newBegin);
+
+    for(std::size_t i = 0; i < origAllIds.size(); i++)
     {
-      lineEndFormat = LINEEND_LINUX;
+      origAllIds[i] = lineIds.emplace(origLines[origBegin + i], lineIds.size()).first->second;
     }
 
-    if(strcmp(outputEOL, "\r") == 0)
+    for(std::size_t i = 0; i < newAllIds.size(); i++)
     {
-      lineEndFormat = LINEEND_MACOLD;
+      newAllIds[i] = lineIds.emplace(newLines[newBegin + i], lineIds.size()).first->second;
     }
 
-    convertLineEnds(out, lineEndFormat);
-  }
+    // remove the lines that are not in the other text
+    std::vector<bool> inOrig(lineIds.size(), false);
+    std::vector<bool> inNew(lineIds.size(), false);
+    origChanged.assign(origLines.size(), false);
+    newChanged.assign(newLines.size(), false);
 
-// check files for 16 or 32 bit encoding
-// the file must have a Byte Order Mark (BOM)
-// NOTE: some std::string functions don't work with NULLs (e.g. length())
-  FileEncoding ASConsole::detectEncoding(const char* data, std::size_t dataSize) const
-  {
-    FileEncoding encoding = ENCODING_8BIT;
+    for(std::size_t i = 0; i < origAllIds.size(); i++)
+    {
+      inOrig[origAllIds[i]] = true;
+    }
 
-    if(dataSize >= 4 && memcmp(data, "\x00\x00\xFE\xFF", 4) == 0)
+    for(std::size_t i = 0; i < newAllIds.size(); i++)
     {
-      encoding = UTF_32BE;
+      inNew[newAllIds[i]] = true;
     }
-    else if(dataSize >= 4 && memcmp(data, "\xFF\xFE\x00\x00", 4) == 0)
+
+    for(std::size_t i = 0; i < origAllIds.size(); i++)
     {
-      encoding = UTF_32LE;
+      if(inNew[origAllIds[i]])
+      {
+        origIds.push_back(origAllIds[i]);
+        origIndex.push_back(origBegin + i);
+      }
+      else
+      {
+        origChanged[origBegin + i] = true;
+      }
     }
-    else if(dataSize >= 2 && memcmp(data, "\xFE\xFF", 2) == 0)
+
+    for(std::size_t i = 0; i < newAllIds.size(); i++)
     {
-      encoding = UTF_16BE;
+      if(inOrig[newAllIds[i]])
+      {
+        newIds.push_back(newAllIds[i]);
+        newIndex.push_back(newBegin + i);
+      }
+      else
+      {
+        newChanged[newBegin + i] = true;
+      }
     }
-    else if(dataSize >= 2 && memcmp(data, "\xFF\xFE", 2) == 0)
+
+    // the diagonals are from -newIds.size() to origIds.size(), plus one on each side
+    forwardX.resize(origIds.size() + newIds.size() + 3);
+    backwardX.resize(origIds.size() + newIds.size() + 3);
+    diagonalOffset = static_cast<std::ptrdiff_t>(newIds.size()) + 1;
+
+    // about twice the square root of the diagonals, but not less than 256
+    tooExpensive = 1;
+
+    for(std::size_t diagonals = forwardX.size(); diagonals != 0; diagonals >>= 2)
     {
-      encoding = UTF_16LE;
+      tooExpensive <<= 1;
     }
 
-    return encoding;
+    tooExpensive = std::max(tooExpensive, static_cast<std::size_t>(256));
+
+    compareLines(0, static_cast<std::ptrdiff_t>(origIds.size()),
+                 0, static_cast<std::ptrdiff_t>(newIds.size()));
+    buildEdits();
   }
 
-// error exit without a message
-  void ASConsole::error() const
+  const std::vector<ASLineEdit>& ASLineDiff::getEdits() const
   {
-    (*_err) << _("\nArtistic Style has terminated") << std::endl;
-    exit(EXIT_FAILURE);
+    return edits;
   }
 
-// error exit with a message
-  void ASConsole::error(const char* why, const char* what) const
+// lines of the new text including the line ends
+  const std::vector<std::string_view>& ASLineDiff::getNewLines() const
   {
-    (*_err) << why << ' ' << what << std::endl;
-    error();
+    return newLines;
+  }
+
+// lines of the original text including the line ends
+  const std::vector<std::string_view>& ASLineDiff::getOrigLines() const
+  {
+    return origLines;
+  }
+
+// append a diff line, a line without a line end is marked as in diff
+  void ASLineDiff::appendLine(std::string& diffOut, char prefix, std::string_view line) const
+  {
+    diffOut += prefix;
+    diffOut.append(line.data(), line.length());
+
+    if(line.empty() || line.back() != '\n')
+    {
+      diffOut += "\n\\ No newline at end of file\n";
+    }
   }
 
   /**
-   * If no files have been given, use cin for input and cout for output.
-   *
-   * This is used to format text for text editors like TextWrangler (Mac).
-   * Do NOT display any console messages when this function is used.
+   * Build the edits from the changed lines.
+   * The unchanged lines of both texts are matched in order,
+   * so an edit ends at the next line that is unchanged in both texts.
    */
-  void ASConsole::formatCinToCout() const
+  void ASLineDiff::buildEdits()
   {
-    verifyCinPeek();
-    ASStreamIterator<std::istream> streamIterator(&std::cin);     // create iterator for cin
-    formatter.init(&streamIterator);
+    std::size_t i = 0;
+    std::size_t j = 0;
 
-    while(formatter.hasMoreLines())
+    while(i < origLines.size() || j < newLines.size())
     {
-      std::cout << formatter.nextLine();
-
-      if(formatter.hasMoreLines())
+      if((i < origLines.size() && origChanged[i]) || (j < newLines.size() && newChanged[j]))
       {
-        std::cout << streamIterator.getOutputEOL();
+        ASLineEdit edit;
+        edit.origLine = i;
+        edit.newLine = j;
+
+        while(i < origLines.size() && origChanged[i])
+        {
+          i++;
+        }
+
+        while(j < newLines.size() && newChanged[j])
+        {
+          j++;
+        }
+
+        edit.deleteCount = i - edit.origLine;
+        edit.insertCount = j - edit.newLine;
+        edits.push_back(edit);
       }
       else
       {
-        // this can happen if the file if missing a closing bracket and break-blocks is requested
-        if(formatter.getIsLineReady())
-        {
-          std::cout << streamIterator.getOutputEOL();
-          std::cout << formatter.nextLine();
-        }
+        i++;
+        j++;
       }
     }
-
-    std::cout.flush();
   }
 
   /**
-   * Verify that tellg() works with cin.
-   * This will fail if cin is piped to AStyle "cat txt.cpp | ./astyled".
-   * But is OK for redirection "./astyled < txt.cpp".
+   * Mark the changed lines in a range of the compared lines by dividing the range
+   * at the middle of its edit path until a part is only inserts or deletes.
+   * x is the original line and y is the new line.
    */
-  void ASConsole::verifyCinPeek() const
+  void ASLineDiff::compareLines(std::ptrdiff_t xOff, std::ptrdiff_t xLim,
+                                std::ptrdiff_t yOff, std::ptrdiff_t yLim)
   {
-    std::int32_t currPos = static_cast<std::int32_t>(std::cin.tellg());
+    // skip the equal lines at the beginning and the end
+    while(xOff < xLim && yOff < yLim && origIds[xOff] == newIds[yOff])
+    {
+      xOff++;
+      yOff++;
+    }
 
-    if(currPos == -1)
+    while(xOff < xLim && yOff < yLim && origIds[xLim - 1] == newIds[yLim - 1])
     {
-      (*_err) << _("Cannot process the input stream") << std::endl;
-      error();
+      xLim--;
+      yLim--;
+    }
+
+    if(xOff == xLim)
+    {
+      while(yOff < yLim)
+      {
+        newChanged[newIndex[yOff++]] = true;
+      }
+    }
+    else if(yOff == yLim)
+    {
+      while(xOff < xLim)
+      {
+        origChanged[origIndex[xOff++]] = true;
+      }
+    }
+    else
+    {
+      std::ptrdiff_t xMid;
+      std::ptrdiff_t yMid;
+      findMiddleSnake(xOff, xLim, yOff, yLim, xMid, yMid);
+      compareLines(xOff, xMid, yOff, yMid);
+      compareLines(xMid, xLim, yMid, yLim);
     }
   }
 
   /**
-   * Open input file, format it, and close the output.
-   *
-   * @param fileName_     The path and name of the file to be processed.
+   * Find the middle of the shortest edit path for a range of the texts.
+   * The paths are extended forward from the beginning and backward from
+   * the end, one edit at a time, until they overlap on a diagonal. When
+   * the edit cost becomes too expensive, the furthest path is used so the
+   * time is limited, and the diff may not be minimal.
    */
-  void ASConsole::formatFile(const std::string& fileName_)
+  void ASLineDiff::findMiddleSnake(std::ptrdiff_t xOff, std::ptrdiff_t xLim,
+                                   std::ptrdiff_t yOff, std::ptrdiff_t yLim,
+                                   std::ptrdiff_t& xMid, std::ptrdiff_t& yMid)
   {
-    std::stringstream in;
-    std::ostringstream out;
-    FileEncoding encoding = readFile(fileName_, in);
-
-    // Unless a specific language mode has been set, set the language mode
-    // according to the file's suffix.
-    if(!formatter.getModeManuallySet())
-    {
-      if(stringEndsWith(fileName_, std::string(".java")))
+    std::ptrdiff_t* fd = &forwardX[diagonalOffset];     // indexed by the diagonal x - y
+    std::ptrdiff_t* bd = &backwardX[diagonalOffset];    // indexed by the diagonal x - y
+    const std::ptrdiff_t dMin = xOff - yLim;
+    const std::ptrdiff_t dMax = xLim - yOff;
+    const std::ptrdiff_t fMid = xOff - yOff;
+    const std::ptrdiff_t bMid = xLim - yLim;
+    const bool isOdd = ((fMid - bMid) & 1) != 0;
+    std::ptrdiff_t fMin = fMid;
+    std::ptrdiff_t fMax = fMid;
+    std::ptrdiff_t bMin = bMid;
+    std::ptrdiff_t bMax = bMid;
+    fd[fMid] = xOff;
+    bd[bMid] = xLim;
+
+    for(std::size_t cost = 1;; cost++)
+    {
+      // extend the forward paths by one edit
+      if(fMin > dMin)
+      {
+        fd[--fMin - 1] = -1;
+      }
+      else
       {
-        formatter.setJavaStyle();
+        ++fMin;
       }
-      else if(stringEndsWith(fileName_, std::string(".cs")))
+
+      if(fMax < dMax)
       {
-        formatter.setSharpStyle();
+        fd[++fMax + 1] = -1;
       }
       else
       {
-        formatter.setCStyle();
+        --fMax;
       }
-    }
 
-    // set line end format
-    std::string nextLine;        // next output line
-    filesAreIdentical = true;    // input and output files are identical
-    LineEndFormat lineEndFormat = formatter.getLineEndFormat();
-    initializeOutputEOL(lineEndFormat);
-    // do this AFTER setting the file mode
-    ASStreamIterator<std::stringstream> streamIterator(&in);
-    formatter.init(&streamIterator);
+      for(std::ptrdiff_t d = fMax; d >= fMin; d -= 2)
+      {
+        std::ptrdiff_t x = (fd[d - 1] < fd[d + 1]) ? fd[d + 1] : fd[d - 1] + 1;
+        std::ptrdiff_t y = x - d;
 
-    // format the file
-    while(formatter.hasMoreLines())
-    {
-      nextLine = formatter.nextLine();
-      out << nextLine;
-      linesOut++;
+        while(x < xLim && y < yLim && origIds[x] == newIds[y])
+        {
+          x++;
+          y++;
+        }
 
-      if(formatter.hasMoreLines())
+        fd[d] = x;
+
+        if(isOdd && bMin <= d && d <= bMax && bd[d] <= x)
+        {
+          xMid = x;
+          yMid = y;
+          return;
+        }
+      }
+
+      // extend the backward paths by one edit
+      if(bMin > dMin)
       {
-        setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-        out << outputEOL;
+        bd[--bMin - 1] = PTRDIFF_MAX;
       }
       else
       {
-        streamIterator.saveLastInputLine();     // to compare the last input line
+        ++bMin;
+      }
 
-        // this can happen if the file if missing a closing bracket and break-blocks is requested
-        if(formatter.getIsLineReady())
-        {
-          setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-          out << outputEOL;
-          nextLine = formatter.nextLine();
-          out << nextLine;
-          linesOut++;
-          streamIterator.saveLastInputLine();
-        }
+      if(bMax < dMax)
+      {
+        bd[++bMax + 1] = PTRDIFF_MAX;
+      }
+      else
+      {
+        --bMax;
       }
 
-      if(filesAreIdentical)
+      for(std::ptrdiff_t d = bMax; d >= bMin; d -= 2)
       {
-        if(streamIterator.checkForEmptyLine)
+        std::ptrdiff_t x = (bd[d - 1] < bd[d + 1]) ? bd[d - 1] : bd[d + 1] - 1;
+        std::ptrdiff_t y = x - d;
+
+        while(x > xOff && y > yOff && origIds[x - 1] == newIds[y - 1])
         {
-          if(nextLine.find_first_not_of(" \t") != std::string::npos)
-          {
-            filesAreIdentical = false;
-          }
+          x--;
+          y--;
         }
-        else if(!streamIterator.compareToInputBuffer(nextLine))
+
+        bd[d] = x;
+
+        if(!isOdd && fMin <= d && d <= fMax && x <= fd[d])
         {
-          filesAreIdentical = false;
+          xMid = x;
+          yMid = y;
+          return;
         }
+      }
 
-        streamIterator.checkForEmptyLine = false;
+      if(cost < tooExpensive)
+      {
+        continue;
       }
-    }
 
-    // correct for mixed line ends
-    if(lineEndsMixed)
-    {
-      correctMixedLineEnds(out);
-      filesAreIdentical = false;
-    }
+      // use the forward path that is furthest from the beginning
+      std::ptrdiff_t fxyBest = -1;
+      std::ptrdiff_t fxBest = xOff;
 
-    // remove targetDirectory from filename if required by print
-    std::string displayName;
+      for(std::ptrdiff_t d = fMax; d >= fMin; d -= 2)
+      {
+        std::ptrdiff_t x = std::min(fd[d], xLim);
+        std::ptrdiff_t y = x - d;
 
-    if(hasWildcard)
-    {
-      displayName = fileName_.substr(targetDirectory.length() + 1);
-    }
-    else
-    {
-      displayName = fileName_;
+        if(y > yLim)
+        {
+          x = yLim + d;
+          y = yLim;
+        }
+
+        if(x + y > fxyBest)
+        {
+          fxyBest = x + y;
+          fxBest = x;
+        }
+      }
+
+      // or the backward path that is furthest from the end
+      std::ptrdiff_t bxyBest = PTRDIFF_MAX;
+      std::ptrdiff_t bxBest = xLim;
+
+      for(std::ptrdiff_t d = bMax; d >= bMin; d -= 2)
+      {
+        std::ptrdiff_t x = std::max(xOff, bd[d]);
+        std::ptrdiff_t y = x - d;
+
+        if(y < yOff)
+        {
+          x = yOff + d;
+          y = yOff;
+        }
+
+        if(x + y < bxyBest)
+        {
+          bxyBest = x + y;
+          bxBest = x;
+        }
+      }
+
+      if((xLim + yLim) - bxyBest < fxyBest - (xOff + yOff))
+      {
+        xMid = fxBest;
+        yMid = fxyBest - fxBest;
+      }
+      else
+      {
+        xMid = bxBest;
+        yMid = bxyBest - bxBest;
+      }
+
+      return;
+    }
+  }
+
+  /**
+   * Split a text into lines that include their line ends.
+   * A line ends with LF, or with CRLF or CR if CR line ends are split.
+   * Otherwise a CR is part of the line, as in diff and patch.
+   * The last line may not have a line end.
+   */
+  void ASLineDiff::splitLines(std::string_view text, std::vector<std::string_view>& lines) const
+  {
+    std::size_t lineStart = 0;
+
+    // the line ends are found by a scan, which is faster than find_first_of
+    while(lineStart < text.length())
+    {
+      std::size_t lineEnd = lineStart;
+
+      while(lineEnd < text.length() && text[lineEnd] != '\n'
+            && (text[lineEnd] != '\r' || !isCRLineEnd))
+      {
+        lineEnd++;
+      }
+
+      // a CRLF is one line end
+      if(lineEnd < text.length())
+      {
+        if(text[lineEnd] == '\r' && lineEnd + 1 < text.length()
+            && text[lineEnd + 1] == '\n')
+        {
+          lineEnd++;
+        }
+
+        lineEnd++;
+      }
+
+      lines.push_back(text.substr(lineStart, lineEnd - lineStart));
+      lineStart = lineEnd;
+    }
+  }
+
+  /**
+   * Write the edits as a compact edit list.
+   * Each edit is a header line with the original line, the number of lines deleted,
+   * the number of lines inserted, and the size of the inserted text, separated by spaces.
+   * The header is followed by the inserted text, which has the line ends of the new text.
+   * The lines are numbered from zero and the edits are in line order.
+   * The lines are split as in the constructor, so without splitAtCR only LF ends
+   * a line and the source lines of an old Mac text are one line.
+   * An empty list means the texts are equal.
+   *
+   * @param editsOut      The string to append the edit list to.
+   */
+  void ASLineDiff::writeEditList(std::string& editsOut) const
+  {
+    for(std::size_t i = 0; i < edits.size(); i++)
+    {
+      const ASLineEdit& edit = edits[i];
+      std::size_t insertSize = 0;
+
+      for(std::size_t j = edit.newLine; j < edit.newLine + edit.insertCount; j++)
+      {
+        insertSize += newLines[j].length();
+      }
+
+      editsOut += std::to_string(edit.origLine) + ' ' + std::to_string(edit.deleteCount) + ' '
+                  + std::to_string(edit.insertCount) + ' ' + std::to_string(insertSize) + '\n';
+
+      for(std::size_t j = edit.newLine; j < edit.newLine + edit.insertCount; j++)
+      {
+        editsOut.append(newLines[j]);
+      }
+    }
+  }
+
+  /**
+   * Write the edits as a unified diff with context lines.
+   * Edits that are separated by no more than twice the context lines
+   * are written in the same hunk.
+   *
+   * @param diffOut       The string to append the diff to.
+   * @param origName      The name of the original file for the header.
+   * @param newName       The name of the new file for the header.
+   * @param contextLines  The number of unchanged lines around each edit.
+   */
+  void ASLineDiff::writeUnifiedDiff(std::string& diffOut, const std::string& origName,
+                                    const std::string& newName, std::size_t contextLines) const
+  {
+    if(edits.empty())
+    {
+      return;
+    }
+
+    diffOut.append("--- ").append(origName).append("\n");
+    diffOut.append("+++ ").append(newName).append("\n");
+
+    std::size_t first = 0;
+
+    while(first < edits.size())
+    {
+      // find the edits in the hunk
+      std::size_t last = first;
+
+      while(last + 1 < edits.size()
+              && edits[last + 1].origLine - (edits[last].origLine + edits[last].deleteCount)
+              <= 2 * contextLines)
+      {
+        last++;
+      }
+
+      const ASLineEdit& firstEdit = edits[first];
+      const ASLineEdit& lastEdit = edits[last];
+      std::size_t leading = std::min(firstEdit.origLine, contextLines);
+      std::size_t origStart = firstEdit.origLine - leading;
+      std::size_t origEnd = std::min(lastEdit.origLine + lastEdit.deleteCount + contextLines,
+                                     origLines.size());
+      std::size_t newStart = firstEdit.newLine - leading;
+      std::size_t newEnd = lastEdit.newLine + lastEdit.insertCount
+                           + (origEnd - (lastEdit.origLine + lastEdit.deleteCount));
+
+      // the header line numbers start at one, an empty range uses the line before
+      std::size_t ranges[4] = { origStart, origEnd - origStart, newStart, newEnd - newStart };
+      diffOut.append("@@");
+
+      for(std::size_t i = 0; i < 4; i += 2)
+      {
+        diffOut.append(i == 0 ? " -" : " +");
+        diffOut.append(std::to_string(ranges[i + 1] == 0 ? ranges[i] : ranges[i] + 1));
+
+        if(ranges[i + 1] != 1)
+        {
+          diffOut.append(",").append(std::to_string(ranges[i + 1]));
+        }
+      }
+
+      diffOut.append(" @@\n");
+
+      // write the context and changed lines
+      std::size_t origLine = origStart;
+
+      for(std::size_t i = first; i <= last; i++)
+      {
+        const ASLineEdit& edit = edits[i];
+
+        for(; origLine < edit.origLine; origLine++)
+        {
+          appendLine(diffOut, ' ', origLines[origLine]);
+        }
+
+        for(std::size_t j = 0; j < edit.deleteCount; j++)
+        {
+          appendLine(diffOut, '-', origLines[origLine++]);
+        }
+
+        for(std::size_t j = 0; j < edit.insertCount; j++)
+        {
+          appendLine(diffOut, '+', newLines[edit.newLine + j]);
+        }
+      }
+
+      for(; origLine < origEnd; origLine++)
+      {
+        appendLine(diffOut, ' ', origLines[origLine]);
+      }
+
+      first = last + 1;
+    }
+  }
+
+#ifndef ASTYLE_LIB
+//-----------------------------------------------------------------------------
+// ASFileBuffer class
+//-----------------------------------------------------------------------------
+
+// clear the buffer for the next file, the streams keep their objects
+  void ASFileBuffer::clear()
+  {
+    fileName.clear();
+    in.str(std::string());
+    in.clear();
+    out.str(std::string());
+    out.clear();
+    encoding = ENCODING_8BIT;
+    pendingEOL = '\0';
+    eolWindows = 0;
+    eolLinux = 0;
+    eolMacOld = 0;
+    isChanged = false;
+    isVerified = true;
+    isStreamed = false;
+    isTempFileRenamed = false;
+    tempFileName.clear();
+    errorMessage.clear();
+    errorFileName.clear();
+  }
+
+//-----------------------------------------------------------------------------
+// ASFileQueue class
+//-----------------------------------------------------------------------------
+
+// no more buffers will be pushed, pop() returns false when the queue is empty
+  void ASFileQueue::close()
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    isClosed = true;
+    notEmpty.notify_all();
+  }
+
+// sum of the buffers waiting in the queue each time a buffer is pushed
+// call after the pipeline threads have finished
+  std::size_t ASFileQueue::getOccupancySum() const
+  {
+    return occupancySum;
+  }
+
+// number of buffers pushed
+// call after the pipeline threads have finished
+  std::size_t ASFileQueue::getPushCount() const
+  {
+    return pushCount;
+  }
+
+// wait for a buffer
+// return false if the queue is closed and empty
+  bool ASFileQueue::pop(ASFileBuffer*& buffer)
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while(queue.empty() && !isClosed)
+    {
+      notEmpty.wait(lock);
+    }
+
+    if(queue.empty())
+    {
+      return false;
+    }
+
+    buffer = queue.front();
+    queue.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+// wait for space in the queue and add a buffer
+  void ASFileQueue::push(ASFileBuffer* buffer)
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while(queue.size() >= depth)
+    {
+      notFull.wait(lock);
+    }
+
+    occupancySum += queue.size();
+    pushCount++;
+    queue.push_back(buffer);
+    notEmpty.notify_one();
+  }
+
+//-----------------------------------------------------------------------------
+// ASJsonValue class
+//-----------------------------------------------------------------------------
+
+// array elements, empty if the value is not an array
+  const std::vector<ASJsonValue>& ASJsonValue::getElements() const
+  {
+    static const std::vector<ASJsonValue> noElements;
+
+    if(type != JSON_ARRAY)
+    {
+      return noElements;
+    }
+
+    return elements;
+  }
+
+// integer value of a number, zero if the value is not a number
+  std::int64_t ASJsonValue::getInteger() const
+  {
+    if(type != JSON_NUMBER)
+    {
+      return 0;
+    }
+
+    return std::strtoll(text.c_str(), nullptr, 10);
+  }
+
+// the value as JSON text
+  std::string ASJsonValue::getJson() const
+  {
+    std::string jsonText;
+
+    switch(type)
+    {
+    case JSON_NULL:
+      jsonText = "null";
+      break;
+
+    case JSON_BOOLEAN:
+    case JSON_NUMBER:
+      jsonText = text;
+      break;
+
+    case JSON_STRING:
+      jsonText = quote(text);
+      break;
+
+    case JSON_ARRAY:
+    case JSON_OBJECT:
+      jsonText = (type == JSON_ARRAY) ? "[" : "{";
+
+      for(std::size_t i = 0; i < elements.size(); i++)
+      {
+        if(i > 0)
+        {
+          jsonText += ',';
+        }
+
+        if(type == JSON_OBJECT)
+        {
+          jsonText += quote(memberNames[i]) + ':';
+        }
+
+        jsonText += elements[i].getJson();
+      }
+
+      jsonText += (type == JSON_ARRAY) ? "]" : "}";
+      break;
+    }
+
+    return jsonText;
+  }
+
+// member of an object, a null value if there is no such member
+  const ASJsonValue& ASJsonValue::getMember(const std::string& name) const
+  {
+    static const ASJsonValue nullValue;
+
+    if(type == JSON_OBJECT)
+    {
+      for(std::size_t i = 0; i < memberNames.size(); i++)
+      {
+        if(memberNames[i] == name)
+        {
+          return elements[i];
+        }
+      }
+    }
+
+    return nullValue;
+  }
+
+// string value, empty if the value is not a string
+  const std::string& ASJsonValue::getString() const
+  {
+    static const std::string noString;
+
+    if(type != JSON_STRING)
+    {
+      return noString;
+    }
+
+    return text;
+  }
+
+  bool ASJsonValue::isNull() const
+  {
+    return type == JSON_NULL;
+  }
+
+  /**
+   * Parse a JSON text into this value.
+   *
+   * @param jsonText      The JSON text.
+   * @return              false if the text is not valid JSON.
+   */
+  bool ASJsonValue::parse(const std::string& jsonText)
+  {
+    std::size_t pos = 0;
+
+    if(!parseValue(jsonText, pos, 0))
+    {
+      return false;
+    }
+
+    skipSpace(jsonText, pos);
+    return pos == jsonText.length();
+  }
+
+// parse the four hex digits of an escaped UTF-16 code unit
+  bool ASJsonValue::parseCodeUnit(const std::string& jsonText, std::size_t& pos, std::uint32_t& codeUnit) const
+  {
+    if(pos + 4 > jsonText.length()
+        || jsonText.find_first_not_of("0123456789abcdefABCDEF", pos) < pos + 4)
+    {
+      return false;
+    }
+
+    codeUnit = std::strtoul(jsonText.substr(pos, 4).c_str(), nullptr, 16);
+    pos += 4;
+    return true;
+  }
+
+  /**
+   * Parse a JSON string starting at the opening quote.
+   * Escaped UTF-16 characters, including surrogate pairs, are converted to UTF-8.
+   *
+   * @param jsonText      The JSON text.
+   * @param pos           The position of the opening quote, updated to follow the closing quote.
+   * @param value         Receives the unescaped string.
+   * @return              false if the string is not valid.
+   */
+  bool ASJsonValue::parseString(const std::string& jsonText, std::size_t& pos, std::string& value) const
+  {
+    value.clear();
+    pos++;
+
+    while(pos < jsonText.length())
+    {
+      char ch = jsonText[pos++];
+
+      if(ch == '"')
+      {
+        return true;
+      }
+
+      if(ch != '\\')
+      {
+        value += ch;
+        continue;
+      }
+
+      if(pos >= jsonText.length())
+      {
+        return false;
+      }
+
+      ch = jsonText[pos++];
+
+      switch(ch)
+      {
+      case '"':
+      case '\\':
+      case '/':
+        value += ch;
+        break;
+
+      case 'b':
+        value += '\b';
+        break;
+
+      case 'f':
+        value += '\f';
+        break;
+
+      case 'n':
+        value += '\n';
+        break;
+
+      case 'r':
+        value += '\r';
+        break;
+
+      case 't':
+        value += '\t';
+        break;
+
+      case 'u':
+      {
+        std::uint32_t codePoint;
+
+        if(!parseCodeUnit(jsonText, pos, codePoint))
+        {
+          return false;
+        }
+
+        // a high surrogate is combined with the following low surrogate
+        if(codePoint >= 0xD800 && codePoint <= 0xDBFF)
+        {
+          std::uint32_t lowSurrogate;
+
+          if(jsonText.compare(pos, 2, "\\u") != 0)
+          {
+            return false;
+          }
+
+          pos += 2;
+
+          if(!parseCodeUnit(jsonText, pos, lowSurrogate)
+              || lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
+          {
+            return false;
+          }
+
+          codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+        }
+
+        if(codePoint < 0x80)
+        {
+          value += static_cast<char>(codePoint);
+        }
+        else if(codePoint < 0x800)
+        {
+          value += static_cast<char>(0xC0 | (codePoint >> 6));
+          value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if(codePoint < 0x10000)
+        {
+          value += static_cast<char>(0xE0 | (codePoint >> 12));
+          value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+          value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+          value += static_cast<char>(0xF0 | (codePoint >> 18));
+          value += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+          value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+          value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+
+        break;
+      }
+
+      default:
+        return false;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Parse a JSON value.
+   * The nesting depth is limited so a malformed message cannot exhaust the stack.
+   *
+   * @param jsonText      The JSON text.
+   * @param pos           The position to start, updated to follow the value.
+   * @param depth         The nesting depth of the value.
+   * @return              false if the value is not valid.
+   */
+  bool ASJsonValue::parseValue(const std::string& jsonText, std::size_t& pos, std::size_t depth)
+  {
+    const std::size_t maxDepth = 256;
+
+    skipSpace(jsonText, pos);
+
+    if(pos >= jsonText.length() || depth > maxDepth)
+    {
+      return false;
+    }
+
+    char ch = jsonText[pos];
+
+    if(ch == '{' || ch == '[')
+    {
+      char closeCh = (ch == '{') ? '}' : ']';
+      type = (ch == '{') ? JSON_OBJECT : JSON_ARRAY;
+      pos++;
+      skipSpace(jsonText, pos);
+
+      if(pos < jsonText.length() && jsonText[pos] == closeCh)
+      {
+        pos++;
+        return true;
+      }
+
+      while(true)
+      {
+        if(type == JSON_OBJECT)
+        {
+          std::string name;
+          skipSpace(jsonText, pos);
+
+          if(pos >= jsonText.length() || jsonText[pos] != '"'
+              || !parseString(jsonText, pos, name))
+          {
+            return false;
+          }
+
+          skipSpace(jsonText, pos);
+
+          if(pos >= jsonText.length() || jsonText[pos] != ':')
+          {
+            return false;
+          }
+
+          pos++;
+          memberNames.push_back(name);
+        }
+
+        elements.push_back(ASJsonValue());
+
+        if(!elements.back().parseValue(jsonText, pos, depth + 1))
+        {
+          return false;
+        }
+
+        skipSpace(jsonText, pos);
+
+        if(pos >= jsonText.length())
+        {
+          return false;
+        }
+
+        ch = jsonText[pos++];
+
+        if(ch == closeCh)
+        {
+          return true;
+        }
+
+        if(ch != ',')
+        {
+          return false;
+        }
+      }
+    }
+
+    if(ch == '"')
+    {
+      type = JSON_STRING;
+      return parseString(jsonText, pos, text);
+    }
+
+    std::size_t end = jsonText.find_first_not_of("+-.0123456789Eaeflnrstu", pos);
+
+    if(end == std::string::npos)
+    {
+      end = jsonText.length();
+    }
+
+    text = jsonText.substr(pos, end - pos);
+    pos = end;
+
+    if(text == "true" || text == "false")
+    {
+      type = JSON_BOOLEAN;
+      return true;
+    }
+
+    if(text == "null")
+    {
+      type = JSON_NULL;
+      return true;
+    }
+
+    if(text.empty() || text.find_first_not_of("+-.0123456789Ee") != std::string::npos)
+    {
+      return false;
+    }
+
+    type = JSON_NUMBER;
+    return true;
+  }
+
+// quote and escape a string for JSON
+// characters above ASCII are left as UTF-8
+  std::string ASJsonValue::quote(const std::string& text)
+  {
+    const char hexDigits[] = "0123456789abcdef";
+    std::string quoted;
+    quoted.reserve(text.length() + 2);
+    quoted += '"';
+
+    for(std::size_t i = 0; i < text.length(); i++)
+    {
+      unsigned char ch = static_cast<unsigned char>(text[i]);
+
+      if(ch == '"' || ch == '\\')
+      {
+        quoted += '\\';
+        quoted += static_cast<char>(ch);
+      }
+      else if(ch == '\n')
+      {
+        quoted += "\\n";
+      }
+      else if(ch == '\r')
+      {
+        quoted += "\\r";
+      }
+      else if(ch == '\t')
+      {
+        quoted += "\\t";
+      }
+      else if(ch < 0x20)
+      {
+        quoted += "\\u00";
+        quoted += hexDigits[ch >> 4];
+        quoted += hexDigits[ch & 0x0F];
+      }
+      else
+      {
+        quoted += static_cast<char>(ch);
+      }
+    }
+
+    quoted += '"';
+    return quoted;
+  }
+
+  void ASJsonValue::skipSpace(const std::string& jsonText, std::size_t& pos) const
+  {
+    while(pos < jsonText.length()
+          && (jsonText[pos] == ' ' || jsonText[pos] == '\t'
+              || jsonText[pos] == '\n' || jsonText[pos] == '\r'))
+    {
+      pos++;
+    }
+  }
+
+//-----------------------------------------------------------------------------
+// ASConsole class
+// main function will be included only in the console build
+//-----------------------------------------------------------------------------
+
+  /**
+   * count the line ends in a block of input the same way ASStreamIterator does,
+   *     so the output line end can be chosen before the file is formatted.
+   * a line end is held in the buffer pendingEOL until the next character is known.
+   * a single line end at the end of the file is not counted.
+   */
+  void ASConsole::countLineEnds(const char* data, std::size_t dataSize, ASFileBuffer& buffer) const
+  {
+    char& pendingEOL = buffer.pendingEOL;
+
+    for(std::size_t i = 0; i < dataSize; i++)
+    {
+      char ch = data[i];
+
+      if(pendingEOL != '\0')
+      {
+        if((pendingEOL == '\r' && ch == '\n') || (pendingEOL == '\n' && ch == '\r'))
+        {
+          buffer.eolWindows++;   // CR+LF, allow for improbable LF/CR
+          pendingEOL = '\0';
+          continue;
+        }
+
+        if(pendingEOL == '\r')
+        {
+          buffer.eolMacOld++;
+        }
+        else
+        {
+          buffer.eolLinux++;
+        }
+
+        pendingEOL = '\0';
+      }
+
+      if(ch == '\r' || ch == '\n')
+      {
+        pendingEOL = ch;
+      }
+    }
+  }
+
+// check files for 16 or 32 bit encoding
+// the file must have a Byte Order Mark (BOM)
+// NOTE: some std::string functions don't work with NULLs (e.g. length())
+  FileEncoding ASConsole::detectEncoding(const char* data, std::size_t dataSize) const
+  {
+    FileEncoding encoding = ENCODING_8BIT;
+
+    if(dataSize >= 4 && memcmp(data, "\x00\x00\xFE\xFF", 4) == 0)
+    {
+      encoding = UTF_32BE;
+    }
+    else if(dataSize >= 4 && memcmp(data, "\xFF\xFE\x00\x00", 4) == 0)
+    {
+      encoding = UTF_32LE;
+    }
+    else if(dataSize >= 2 && memcmp(data, "\xFE\xFF", 2) == 0)
+    {
+      encoding = UTF_16BE;
+    }
+    else if(dataSize >= 2 && memcmp(data, "\xFF\xFE", 2) == 0)
+    {
+      encoding = UTF_16LE;
+    }
+
+    return encoding;
+  }
+
+// error exit without a message
+  void ASConsole::error() const
+  {
+    (*errorStream) << _("\nArtistic Style has terminated") << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+// error exit with a message
+  void ASConsole::error(const char* why, const char* what) const
+  {
+    (*errorStream) << why << ' ' << what << std::endl;
+    error();
+  }
+
+// error exit for a file error recorded in the buffer
+  void ASConsole::checkFileError(const ASFileBuffer& buffer) const
+  {
+    if(!buffer.errorMessage.empty())
+    {
+      error(buffer.errorMessage.c_str(), buffer.errorFileName.c_str());
+    }
+  }
+
+// record a file error in the buffer
+// the pipeline threads must not exit, the error is reported by the main thread
+  void ASConsole::fileError(ASFileBuffer& buffer, const char* why, const char* what) const
+  {
+    buffer.errorMessage = why;
+    buffer.errorFileName = what;
+  }
+
+  /**
+   * If no files have been given, use cin for input and cout for output.
+   *
+   * This is used to format text for text editors like TextWrangler (Mac).
+   * Do NOT display any console messages when this function is used.
+   */
+  void ASConsole::formatCinToCout() const
+  {
+    verifyCinPeek();
+    ASStreamIterator<std::istream> streamIterator(&std::cin);     // create iterator for cin
+    formatter.init(&streamIterator);
+    std::string nextLine;        // reused for each line to keep its capacity
+
+    while(formatter.hasMoreLines())
+    {
+      nextLine.clear();
+      formatter.nextLine(nextLine);
+      std::cout << nextLine;
+
+      if(formatter.hasMoreLines())
+      {
+        std::cout << streamIterator.getOutputEOL();
+      }
+      else
+      {
+        // this can happen if the file if missing a closing bracket and break-blocks is requested
+        if(formatter.getIsLineReady())
+        {
+          std::cout << streamIterator.getOutputEOL();
+          nextLine.clear();
+          formatter.nextLine(nextLine);
+          std::cout << nextLine;
+        }
+      }
+    }
+
+    std::cout.flush();
+
+    // the output has already been written, so only report the failure
+    if(formatter.getChecksumDiff() != 0)
+    {
+      (*errorStream) << _("Formatted output does not match the input stream") << std::endl;
+      error();
+    }
+  }
+
+  /**
+   * Verify that tellg() works with cin.
+   * This will fail if cin is piped to AStyle "cat txt.cpp | ./astyled".
+   * But is OK for redirection "./astyled < txt.cpp".
+   */
+  void ASConsole::verifyCinPeek() const
+  {
+    std::streamoff currPos = std::cin.tellg();
+
+    if(currPos == -1)
+    {
+      (*errorStream) << _("Cannot process the input stream") << std::endl;
+      error();
+    }
+  }
+
+  /**
+   * Format a file in the buffer.
+   * This is the format stage of the file pipeline.
+   * The formatted text is placed in the output buffer and the buffer
+   * is marked if the file must be written.
+   *
+   * @param buffer        The buffer containing the input file.
+   */
+  void ASConsole::formatBuffer(ASFileBuffer& buffer)
+  {
+    const std::string& fileName_ = buffer.fileName;
+
+    // Unless a specific language mode has been set, set the language mode
+    // according to the file's suffix.
+    if(!formatter.getModeManuallySet())
+    {
+      if(stringEndsWith(fileName_, std::string(".java")))
+      {
+        formatter.setJavaStyle();
+      }
+      else if(stringEndsWith(fileName_, std::string(".cs")))
+      {
+        formatter.setSharpStyle();
+      }
+      else
+      {
+        formatter.setCStyle();
+      }
+    }
+
+    // set line end format
+    // the output line end is decided before formatting, from the line ends read
+    // a change of line ends in the input is detected by getLineEndChange
+    LineEndFormat lineEndFormat = formatter.getLineEndFormat();
+    initializeOutputEOL(lineEndFormat, buffer);
+
+    if(buffer.isStreamed)
+    {
+      formatStreamedFile(buffer, lineEndFormat);
+      return;
+    }
+
+    // do this AFTER setting the file mode
+    ASStreamIterator<std::stringstream> streamIterator(&buffer.in);
+    formatter.init(&streamIterator);
+    formatLines(streamIterator, buffer.out, lineEndFormat, buffer);
+  }
+
+  /**
+   * Format the lines of a file and compare them to the input lines.
+   * The formatter must be initialized with the stream iterator.
+   * The buffer is marked if the file must be written.
+   *
+   * @param streamIterator  The iterator for the input file.
+   * @param out             The stream for the formatted text.
+   * @param lineEndFormat   The line end format option.
+   * @param buffer          The buffer for the file.
+   */
+  template<typename T>
+  void ASConsole::formatLines(ASStreamIterator<T>& streamIterator, std::ostream& out,
+                              LineEndFormat lineEndFormat, ASFileBuffer& buffer)
+  {
+    std::string nextLine;        // next output line
+    filesAreIdentical = true;    // input and output files are identical
+
+    // format the file
+    // nextLine is reused for each line to keep its capacity
+    while(formatter.hasMoreLines())
+    {
+      nextLine.clear();
+      formatter.nextLine(nextLine);
+      out << nextLine;
+      linesOut++;
+
+      if(formatter.hasMoreLines())
+      {
+        out << getOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
+      }
+      else
+      {
+        streamIterator.saveLastInputLine();     // to compare the last input line
+
+        // this can happen if the file if missing a closing bracket and break-blocks is requested
+        if(formatter.getIsLineReady())
+        {
+          out << getOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
+          nextLine.clear();
+          formatter.nextLine(nextLine);
+          out << nextLine;
+          linesOut++;
+          streamIterator.saveLastInputLine();
+        }
+      }
+
+      if(filesAreIdentical)
+      {
+        if(streamIterator.checkForEmptyLine)
+        {
+          if(nextLine.find_first_not_of(" \t") != std::string::npos)
+          {
+            filesAreIdentical = false;
+          }
+        }
+        else if(!streamIterator.compareToInputBuffer(nextLine))
+        {
+          filesAreIdentical = false;
+        }
+
+        streamIterator.checkForEmptyLine = false;
+      }
+    }
+
+    buffer.isVerified = (formatter.getChecksumDiff() == 0);
+    buffer.isChanged = (!filesAreIdentical || streamIterator.getLineEndChange(lineEndFormat));
+  }
+
+  /**
+   * Format a large file from the disk to a temporary file.
+   * The file is not held in memory, so a file larger than the memory can be
+   * formatted. The temporary file replaces the file in the write stage.
+   * The line ends were counted when the file was read.
+   *
+   * @param buffer          The buffer for the file, the input text is not used.
+   * @param lineEndFormat   The line end format option.
+   */
+  void ASConsole::formatStreamedFile(ASFileBuffer& buffer, LineEndFormat lineEndFormat)
+  {
+    const std::string& fileName_ = buffer.fileName;
+    std::ifstream fin(fileName_.c_str(), std::ios::binary);
+
+    if(!fin)
+    {
+      fileError(buffer, "Cannot open input file", fileName_.c_str());
+      return;
+    }
+
+    // a file that cannot be renamed is copied back in the write stage
+    buffer.tempFileName = createTempFile(fileName_);
+    buffer.isTempFileRenamed = !buffer.tempFileName.empty();
+
+    if(!buffer.isTempFileRenamed)
+    {
+      buffer.tempFileName = createCopyTempFile(fileName_);
+
+      if(buffer.tempFileName.empty())
+      {
+        fileError(buffer, "Cannot create temporary file", fileName_.c_str());
+        return;
+      }
+    }
+
+    std::ofstream fout(buffer.tempFileName.c_str(), std::ios::binary | std::ios::trunc);
+
+    if(!fout)
+    {
+      remove(buffer.tempFileName.c_str());
+      fileError(buffer, "Cannot open output file", buffer.tempFileName.c_str());
+      return;
+    }
+
+    ASStreamIterator<std::ifstream> streamIterator(&fin);
+    formatter.init(&streamIterator);
+    formatLines(streamIterator, fout, lineEndFormat, buffer);
+    fout.close();
+
+    if(!fout || fin.bad())
+    {
+      remove(buffer.tempFileName.c_str());
+      fileError(buffer, "Cannot write output file", buffer.tempFileName.c_str());
+      return;
+    }
+
+    if(!buffer.isChanged || !buffer.isVerified)
+    {
+      remove(buffer.tempFileName.c_str());
+      buffer.tempFileName.clear();
+    }
+  }
+
+  /**
+   * Open input file, format it, and close the output.
+   *
+   * @param fileName_     The path and name of the file to be processed.
+   */
+  void ASConsole::formatFile(const std::string& fileName_)
+  {
+    ASFileBuffer buffer;
+    buffer.fileName = fileName_;
+    readFile(buffer);
+    checkFileError(buffer);
+    formatBuffer(buffer);
+    checkFileError(buffer);
+    writeBuffer(buffer);
+    checkFileError(buffer);
+  }
+
+  /**
+   * Format the files in the fileName vector with three pipeline stages.
+   * A reader thread reads the files, this thread formats them, and a writer
+   * thread writes the changed files and displays the messages. The stages are
+   * connected by bounded queues and the buffers are reused, so the memory
+   * used is limited to the buffer count.
+   * A file error stops the pipeline. It is reported by this thread after
+   * the files before it have been written.
+   */
+  void ASConsole::formatFilesPipelined()
+  {
+    const std::size_t queueDepth = 4;
+    // a buffer may be in each queue and in each stage
+    std::vector<ASFileBuffer> buffers(queueDepth * 3 + 3);
+    ASFileQueue freeQueue(buffers.size());
+    ASFileQueue readQueue(queueDepth);
+    ASFileQueue writeQueue(queueDepth);
+
+    for(std::size_t i = 0; i < buffers.size(); i++)
+    {
+      freeQueue.push(&buffers[i]);
+    }
+
+    ASFileBuffer* failedBuffer = nullptr;
+    isPipelineStopped = false;
+    std::thread reader(&ASConsole::readFiles, this, std::ref(freeQueue), std::ref(readQueue));
+    std::thread writer(&ASConsole::writeFiles, this, std::ref(writeQueue), std::ref(freeQueue),
+                       std::ref(failedBuffer));
+    ASFileBuffer* buffer;
+
+    // a buffer with an error is passed on so the files before it are written
+    // the files after an error are not formatted
+    while(readQueue.pop(buffer))
+    {
+      if(buffer->errorMessage.empty() && !isPipelineStopped)
+      {
+        formatBuffer(*buffer);
+
+        if(!buffer->errorMessage.empty())
+        {
+          isPipelineStopped = true;
+        }
+      }
+
+      writeQueue.push(buffer);
+    }
+
+    writeQueue.close();
+    reader.join();
+    writer.join();
+
+    if(failedBuffer != nullptr)
+    {
+      checkFileError(*failedBuffer);
+    }
+
+    readOccupancy += readQueue.getOccupancySum();
+    writeOccupancy += writeQueue.getOccupancySum();
+    pipelineFiles += readQueue.getPushCount();
+  }
+
+  /**
+   * Write a formatted file if it has changed and display the message.
+   * This is the write stage of the file pipeline.
+   *
+   * @param buffer        The buffer containing the formatted file.
+   */
+  void ASConsole::writeBuffer(ASFileBuffer& buffer)
+  {
+    const std::string& fileName_ = buffer.fileName;
+
+    // remove targetDirectory from filename if required by print
+    std::string displayName;
+
+    if(hasWildcard)
+    {
+      displayName = fileName_.substr(targetDirectory.length() + 1);
+    }
+    else
+    {
+      displayName = fileName_;
+    }
+
+    // if the output does not match the input, do NOT write the file
+    if(!buffer.isVerified)
+    {
+      (*errorStream) << _("Formatted output does not match the input, file not changed") << ' '
+                     << displayName << std::endl;
+      filesNotVerified++;
+    }
+    // with the diff option, display the changes instead of writing the file
+    else if(isDiff)
+    {
+      if(buffer.isChanged && writeDiff(buffer))
+      {
+        filesFormatted++;
+      }
+      else
+      {
+        filesUnchanged++;
+      }
+    }
+    // if file has changed, write the new file
+    else if(buffer.isChanged)
+    {
+      if(buffer.isStreamed)
+      {
+        writeStreamedFile(buffer);
+      }
+      else
+      {
+        writeFile(buffer);
+      }
+
+      if(!buffer.errorMessage.empty())
+      {
+        return;
+      }
+
+      printMsg(_("Formatted  %s\n"), displayName);
+      filesFormatted++;
+    }
+    else
+    {
+      if(!isFormattedOnly)
+      {
+        printMsg(_("Unchanged  %s\n"), displayName);
+      }
+
+      filesUnchanged++;
+    }
+  }
+
+  /**
+   * Write the changes to a formatted file as a unified diff on the standard output.
+   * The diff is computed from the input and formatted text in the buffer, so the
+   * inserted and deleted lines are shown as well as the changed lines.
+   * The file names in the headers are relative to the current directory.
+   *
+   * @param buffer        The buffer containing the formatted file.
+   * @return              true if the diff has changes.
+   */
+  bool ASConsole::writeDiff(const ASFileBuffer& buffer) const
+  {
+    std::string diffName = buffer.fileName;
+    std::string currentDirectory = getCurrentDirectory(diffName) + g_fileSeparator;
+
+    if(diffName.compare(0, currentDirectory.length(), currentDirectory) == 0)
+    {
+      diffName.erase(0, currentDirectory.length());
+    }
+
+    std::string origText = buffer.in.str();
+    std::string newText = buffer.out.str();
+    ASLineDiff lineDiff(origText, newText);
+    std::string diffOut;
+    lineDiff.writeUnifiedDiff(diffOut, diffName, diffName, 3);
+    fwrite(diffOut.data(), 1, diffOut.length(), stdout);
+    return !lineDiff.getEdits().empty();
+  }
+
+  /**
+   * Read the files in the fileName vector into buffers from the free queue.
+   * This is the read stage of the file pipeline, it runs in its own thread.
+   * The files are prefetched ahead so the reads are kept in flight.
+   * A file that cannot be read is the last buffer pushed.
+   */
+  void ASConsole::readFiles(ASFileQueue& freeQueue, ASFileQueue& readQueue)
+  {
+    const std::size_t prefetchDepth = 16;
+    ASFileBuffer* buffer;
+
+    for(std::size_t i = 0; i < fileName.size() && i < prefetchDepth; i++)
+    {
+      prefetchFile(fileName[i]);
+    }
+
+    for(std::size_t i = 0; i < fileName.size() && !isPipelineStopped && freeQueue.pop(buffer); i++)
+    {
+      if(i + prefetchDepth < fileName.size())
+      {
+        prefetchFile(fileName[i + prefetchDepth]);
+      }
+
+      buffer->fileName = fileName[i];
+      readFile(*buffer);
+      // the buffer may be cleared by the writer after it is pushed
+      bool isReadError = !buffer->errorMessage.empty();
+      readQueue.push(buffer);
+
+      if(isReadError)
+      {
+        break;
+      }
+    }
+
+    readQueue.close();
+  }
+
+  /**
+   * Write the formatted files from the write queue and return the buffers
+   * to the free queue.
+   * This is the write stage of the file pipeline, it runs in its own thread.
+   * The first buffer with an error is kept in failedBuffer for the error message,
+   * the following buffers are returned without being written.
+   */
+  void ASConsole::writeFiles(ASFileQueue& writeQueue, ASFileQueue& freeQueue, ASFileBuffer*& failedBuffer)
+  {
+    ASFileBuffer* buffer;
+
+    while(writeQueue.pop(buffer))
+    {
+      if(failedBuffer == nullptr)
+      {
+        if(buffer->errorMessage.empty())
+        {
+          writeBuffer(*buffer);
+        }
+
+        if(!buffer->errorMessage.empty())
+        {
+          failedBuffer = buffer;
+          isPipelineStopped = true;
+          continue;
+        }
+      }
+      // the temporary file of a streamed file that is not written is removed
+      else if(!buffer->tempFileName.empty())
+      {
+        remove(buffer->tempFileName.c_str());
+      }
+
+      buffer->clear();
+      freeQueue.push(buffer);
+    }
+  }
+
+  /**
+   * Format the files changed since a git revision.
+   * The file names from the command line are used as git pathspecs.
+   * The paths are read from "git diff -z" and formatted as they are read.
+   */
+  void ASConsole::formatChangedFiles()
+  {
+    if(fileNameVector.empty())
+    {
+      error(_("No file names for changed-since"), changedSince.c_str());
+    }
+
+    std::string command = "git diff --name-only --relative -z --diff-filter=d "
+                          + quoteCommandArg(changedSince) + " --";
+
+    for(std::size_t i = 0; i < fileNameVector.size(); i++)
+    {
+      command += ' ' + quoteCommandArg(fileNameVector[i]);
+    }
+
+#ifdef _WIN32
+    FILE* fileList = _popen(command.c_str(), "rb");
+#else
+    FILE* fileList = popen(command.c_str(), "r");
+#endif
+
+    if(fileList == nullptr)
+    {
+      error(_("Cannot run git for changed-since"), changedSince.c_str());
+    }
+
+    formatFileList(fileList);
+
+#ifdef _WIN32
+    std::int32_t status = _pclose(fileList);
+#else
+    std::int32_t status = pclose(fileList);
+#endif
+
+    if(status != 0)
+    {
+      error(_("Cannot get the changed files from git"), changedSince.c_str());
+    }
+  }
+
+  /**
+   * Format the files in a list of paths.
+   * The paths are separated by NUL or newline characters and are formatted
+   * as they are read, so a long list does not build the fileNameVector.
+   *
+   * @param fileList      The open file or pipe containing the paths.
+   */
+  void ASConsole::formatFileList(FILE* fileList)
+  {
+    std::string listPath;
+    std::int32_t ch;
+
+    // the file names are displayed with the full path
+    hasWildcard = false;
+
+    do
+    {
+      ch = getc(fileList);
+
+      if(ch != EOF && ch != '\0' && ch != '\n')
+      {
+        listPath.append(1, static_cast<char>(ch));
+        continue;
+      }
+
+      // a newline separated list may have windows line ends
+      if(listPath.length() > 0 && listPath[listPath.length() - 1] == '\r')
+      {
+        listPath.erase(listPath.length() - 1);
+      }
+
+      if(listPath.length() > 0)
+      {
+        formatListPath(listPath);
+        listPath.clear();
+      }
+    }
+    while(ch != EOF);
+
+    if(ferror(fileList))
+    {
+      error(_("Cannot read file list"), filesFrom.c_str());
+    }
+  }
+
+  /**
+   * Format a file from a file list if it is not excluded.
+   * The path and each of its directories are checked against the excludes.
+   * Paths that are not regular files, such as deleted files, are skipped.
+   *
+   * @param listPath      The path read from the list.
+   */
+  void ASConsole::formatListPath(std::string& listPath)
+  {
+    standardizePath(listPath);
+    struct stat statbuf;
+
+    if(stat(listPath.c_str(), &statbuf) != 0 || !(statbuf.st_mode & S_IFREG))
+    {
+      return;
+    }
+
+    if(isFilePathExcluded(listPath))
+    {
+      printMsg(_("Exclude  %s\n"), listPath);
+      return;
+    }
+
+    formatFile(listPath);
+  }
+
+  /**
+   * Format the members of a tar archive read from the standard input and
+   * write the archive to the standard output.
+   * The members selected by the file names and excludes are formatted and
+   * the other members are copied unchanged. Only one member is held in
+   * memory, so the memory used is limited to the largest formatted member.
+   * The names are from the ustar header, a GNU long name, or a pax path.
+   */
+  void ASConsole::formatTarStream()
+  {
+    const std::size_t blockSize = 512;
+    char header[blockSize];
+    std::string longName;            // name from a GNU long name member
+    std::string paxPath;             // path from a pax extended header
+    std::uint64_t paxSize = 0;       // size from a pax extended header
+    bool paxHasSize = false;         // the pax extended header has the size
+    std::vector<char> memberData;    // reused for the data of each member
+    ASFileBuffer buffer;
+
+    if(fileNameVector.empty())
+    {
+      error(_("No file names for tar"), "--tar");
+    }
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    while(true)
+    {
+      std::size_t headerSize = fread(header, 1, blockSize, stdin);
+
+      if(headerSize == 0)
+      {
+        break;
+      }
+
+      if(headerSize != blockSize)
+      {
+        error(_("Cannot read the tar stream"), "--tar");
+      }
+
+      // an empty block ends the archive, the remaining blocks are copied unchanged
+      if(std::count(header, header + blockSize, '\0') == static_cast<std::ptrdiff_t>(blockSize))
+      {
+        writeTarData(header, blockSize);
+        memberData.resize(65536);
+
+        while((headerSize = fread(memberData.data(), 1, memberData.size(), stdin)) > 0)
+        {
+          writeTarData(memberData.data(), headerSize);
+        }
+
+        break;
+      }
+
+      if(getTarNumber(header + 148, 8) != getTarChecksum(header))
+      {
+        error(_("Invalid tar header"), "--tar");
+      }
+
+      char typeFlag = header[156];
+      std::uint64_t size = paxHasSize ? paxSize : getTarNumber(header + 124, 12);
+
+      // link, device, directory, and fifo members do not have data
+      if(typeFlag >= '1' && typeFlag <= '6')
+      {
+        size = 0;
+      }
+
+      // the names and size for the next member are copied unchanged
+      if(typeFlag == 'K' || typeFlag == 'L' || typeFlag == 'x')
+      {
+        readTarData(memberData, size);
+        writeTarData(header, blockSize);
+        writeTarData(memberData.data(), memberData.size());
+        std::size_t dataSize = static_cast<std::size_t>(size);
+
+        if(typeFlag == 'L')
+        {
+          longName.assign(memberData.data(), std::find(memberData.data(), memberData.data() + dataSize, '\0'));
+        }
+        else if(typeFlag == 'x')
+        {
+          parsePaxHeader(std::string(memberData.data(), dataSize), paxPath, paxSize, paxHasSize);
+        }
+
+        continue;
+      }
+
+      std::string memberName;
+
+      if(!paxPath.empty())
+      {
+        memberName = paxPath;
+      }
+      else if(!longName.empty())
+      {
+        memberName = longName;
+      }
+      else
+      {
+        memberName.assign(header, std::find(header, header + 100, '\0'));
+
+        if(memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+        {
+          memberName = std::string(header + 345, std::find(header + 345, header + 500, '\0'))
+                       + '/' + memberName;
+        }
+      }
+
+      // a member with a pax size is not formatted because the pax header would change
+      if((typeFlag == '0' || typeFlag == '\0' || typeFlag == '7')
+              && !paxHasSize && isTarMemberSelected(memberName))
+      {
+        readTarData(memberData, size);
+        buffer.fileName = memberName;
+        formatTarMember(header, memberData, static_cast<std::size_t>(size), buffer);
+        buffer.clear();
+      }
+      else
+      {
+        writeTarData(header, blockSize);
+        copyTarData(size, memberData);
+      }
+
+      longName.clear();
+      paxPath.clear();
+      paxHasSize = false;
+    }
+
+    fflush(stdout);
+  }
+
+  /**
+   * Format a tar member and write it to the standard output.
+   * The member is written unchanged if formatting does not change it, if the
+   * formatted output does not match the input, or if it is UTF-32.
+   *
+   * @param header        The tar header of the member. The size is updated.
+   * @param memberData    The member data padded to the block size.
+   * @param dataSize      The size of the member data.
+   * @param buffer        The buffer with the member name for formatting.
+   */
+  void ASConsole::formatTarMember(char* header, std::vector<char>& memberData, std::size_t dataSize, ASFileBuffer& buffer)
+  {
+    buffer.encoding = detectEncoding(memberData.data(), dataSize);
+
+    if(buffer.encoding != UTF_32BE && buffer.encoding != UTF_32LE)
+    {
+      appendInput(buffer, memberData.data(), dataSize, true);
+      formatBuffer(buffer);
+
+      if(!buffer.isVerified)
+      {
+        (*errorStream) << _("Formatted output does not match the input, file not changed") << ' '
+                       << buffer.fileName << std::endl;
+        writeTarData(header, 512);
+        writeTarData(memberData.data(), memberData.size());
+        filesNotVerified++;
+        return;
+      }
+      else if(buffer.isChanged)
+      {
+        std::string outData = getOutputData(buffer.encoding, buffer.out.str());
+        setTarNumber(header + 124, 12, outData.length());
+        std::uint32_t checksum = getTarChecksum(header);
+        setTarNumber(header + 148, 7, checksum);
+        header[155] = ' ';
+        outData.append((512 - outData.length() % 512) % 512, '\0');
+        writeTarData(header, 512);
+        writeTarData(outData.c_str(), outData.length());
+        printMsg(_("Formatted  %s\n"), buffer.fileName);
+        filesFormatted++;
+        return;
+      }
+    }
+
+    writeTarData(header, 512);
+    writeTarData(memberData.data(), memberData.size());
+
+    if(!isFormattedOnly)
+    {
+      printMsg(_("Unchanged  %s\n"), buffer.fileName);
+    }
+
+    filesUnchanged++;
+  }
+
+  /**
+   * Copy the data of a tar member from the standard input to the standard output.
+   *
+   * @param size          The size of the member data.
+   * @param copyBuffer    A buffer to use for the copy.
+   */
+  void ASConsole::copyTarData(std::uint64_t size, std::vector<char>& copyBuffer) const
+  {
+    std::uint64_t remaining = (size + 511) / 512 * 512;
+    copyBuffer.resize(65536);
+
+    while(remaining > 0)
+    {
+      std::size_t copySize = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, copyBuffer.size()));
+
+      if(fread(copyBuffer.data(), 1, copySize, stdin) != copySize)
+      {
+        error(_("Cannot read the tar stream"), "--tar");
+      }
+
+      writeTarData(copyBuffer.data(), copySize);
+      remaining -= copySize;
+    }
+  }
+
+  /**
+   * Get the checksum of a tar header.
+   * The checksum field is counted as spaces.
+   */
+  std::uint32_t ASConsole::getTarChecksum(const char* header) const
+  {
+    std::uint32_t checksum = 0;
+
+    for(std::size_t i = 0; i < 512; i++)
+    {
+      checksum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+
+    return checksum;
+  }
+
+  /**
+   * Get a number from a tar header field.
+   * The number is octal, or base-256 if the first byte has the high bit set.
+   */
+  std::uint64_t ASConsole::getTarNumber(const char* field, std::size_t fieldSize) const
+  {
+    std::uint64_t value = 0;
+
+    if(static_cast<unsigned char>(field[0]) & 0x80)
+    {
+      for(std::size_t i = 1; i < fieldSize; i++)
+      {
+        value = (value << 8) | static_cast<unsigned char>(field[i]);
+      }
+
+      return value;
+    }
+
+    std::size_t i = 0;
+
+    while(i < fieldSize && field[i] == ' ')
+    {
+      i++;
+    }
+
+    for(; i < fieldSize && field[i] >= '0' && field[i] <= '7'; i++)
+    {
+      value = (value << 3) | static_cast<std::uint64_t>(field[i] - '0');
+    }
+
+    return value;
+  }
+
+  /**
+   * Check if a tar member is selected for formatting.
+   * The directory and wildcard of a file name must match the member. With
+   * the recursive option the member may be in a sub directory. Hidden files
+   * and directories are not selected, the same as for a directory search.
+   *
+   * @param memberName    The name of the tar member.
+   * @return              true if the member is to be formatted.
+   */
+  bool ASConsole::isTarMemberSelected(const std::string& memberName)
+  {
+    std::string memberPath = memberName;
+    std::string currentPrefix = std::string(".") + g_fileSeparator;
+    standardizePath(memberPath);
+
+    while(memberPath.compare(0, currentPrefix.length(), currentPrefix) == 0)
+    {
+      memberPath.erase(0, currentPrefix.length());
+    }
+
+    if(memberPath.empty() || memberPath[0] == '.'
+            || memberPath.find(std::string(1, g_fileSeparator) + '.') != std::string::npos)
+    {
+      return false;
+    }
+
+    std::size_t separator = memberPath.find_last_of(g_fileSeparator);
+    std::string memberDirectory;
+
+    if(separator != std::string::npos)
+    {
+      memberDirectory = memberPath.substr(0, separator);
+    }
+
+    std::string memberFile = memberPath.substr(separator + 1);
+    bool isSelected = false;
+
+    for(std::size_t i = 0; i < fileNameVector.size() && !isSelected; i++)
+    {
+      std::string entryPath = fileNameVector[i];
+
+      while(entryPath.compare(0, currentPrefix.length(), currentPrefix) == 0)
+      {
+        entryPath.erase(0, currentPrefix.length());
+      }
+
+      separator = entryPath.find_last_of(g_fileSeparator);
+      std::string entryDirectory;
+
+      if(separator != std::string::npos)
+      {
+        entryDirectory = entryPath.substr(0, separator);
+      }
+
+      if(!wildcmp(entryPath.substr(separator + 1).c_str(), memberFile.c_str()))
+      {
+        continue;
+      }
+
+      if(memberDirectory == entryDirectory)
+      {
+        isSelected = true;
+      }
+      else if(isRecursive)
+      {
+        isSelected = entryDirectory.empty()
+                     || memberDirectory.compare(0, entryDirectory.length() + 1,
+                                                entryDirectory + g_fileSeparator) == 0;
+      }
+    }
+
+    if(!isSelected)
+    {
+      return false;
+    }
+
+    if(isFilePathExcluded(memberPath))
+    {
+      printMsg(_("Exclude  %s\n"), memberPath);
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Get the path and size from the records of a pax extended header.
+   * Each record is "length keyword=value\n".
+   */
+  void ASConsole::parsePaxHeader(const std::string& paxData, std::string& paxPath,
+                                 std::uint64_t& paxSize, bool& paxHasSize) const
+  {
+    std::size_t recordStart = 0;
+
+    while(recordStart < paxData.length())
+    {
+      std::size_t recordLength = static_cast<std::size_t>(strtoul(paxData.c_str() + recordStart, nullptr, 10));
+      std::size_t keyStart = paxData.find(' ', recordStart);
+      std::size_t valueStart = paxData.find('=', recordStart);
+
+      if(recordLength == 0 || recordStart + recordLength > paxData.length()
+              || keyStart == std::string::npos || valueStart == std::string::npos
+              || valueStart > recordStart + recordLength)
+      {
+        break;
+      }
+
+      std::string key = paxData.substr(keyStart + 1, valueStart - keyStart - 1);
+      // the value is followed by a newline
+      std::string value = paxData.substr(valueStart + 1, recordStart + recordLength - valueStart - 2);
+
+      if(key == "path")
+      {
+        paxPath = value;
+      }
+      else if(key == "size")
+      {
+        paxSize = strtoull(value.c_str(), nullptr, 10);
+        paxHasSize = true;
+      }
+
+      recordStart += recordLength;
+    }
+  }
+
+  /**
+   * Read the data of a tar member from the standard input.
+   * The data is padded to the block size.
+   */
+  void ASConsole::readTarData(std::vector<char>& memberData, std::uint64_t size) const
+  {
+    std::uint64_t paddedSize = (size + 511) / 512 * 512;
+
+    if(paddedSize > memberData.max_size())
+    {
+      error(_("Cannot read the tar stream"), "--tar");
+    }
+
+    memberData.resize(static_cast<std::size_t>(paddedSize));
+
+    if(fread(memberData.data(), 1, memberData.size(), stdin) != memberData.size())
+    {
+      error(_("Cannot read the tar stream"), "--tar");
+    }
+  }
+
+  /**
+   * Set a number in a tar header field.
+   * The number is octal with a terminating NUL, or base-256 if it is too large.
+   */
+  void ASConsole::setTarNumber(char* field, std::size_t fieldSize, std::uint64_t value) const
+  {
+    if(value < (static_cast<std::uint64_t>(1) << (3 * (fieldSize - 1))))
+    {
+      for(std::size_t i = fieldSize - 1; i > 0; i--)
+      {
+        field[i - 1] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+      }
+
+      field[fieldSize - 1] = '\0';
+      return;
+    }
+
+    for(std::size_t i = fieldSize - 1; i > 0; i--)
+    {
+      field[i] = static_cast<char>(value & 0xff);
+      value >>= 8;
+    }
+
+    field[0] = static_cast<char>(0x80);
+  }
+
+  /**
+   * Write tar data to the standard output.
+   */
+  void ASConsole::writeTarData(const char* data, std::size_t dataSize) const
+  {
+    if(fwrite(data, 1, dataSize, stdout) != dataSize)
+    {
+      error(_("Cannot write the tar stream"), "--tar");
+    }
+  }
+
+  /**
+   * Run a Language Server Protocol formatting server on the standard input and output.
+   * The opened documents are kept in memory and updated by incremental changes.
+   * The formatter keeps the options from the command line and the options file,
+   * the formatting options sent with a request are not used.
+   * A formatting request is answered with the edits to the changed lines only.
+   *
+   * @return              true if the client requested a shutdown before the exit.
+   */
+  bool ASConsole::runLanguageServer()
+  {
+    std::map<std::string, ASLspDocument> documents;    // opened documents by uri
+    std::string messageText;
+    bool isShutdown = false;
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    while(readLspMessage(messageText))
+    {
+      ASJsonValue message;
+
+      // the content of a message with an invalid length was skipped
+      if(messageText.empty())
+      {
+        writeLspMessage("{\"jsonrpc\":\"2.0\",\"id\":null,"
+                        "\"error\":{\"code\":-32600,\"message\":\"Invalid Content-Length\"}}");
+        continue;
+      }
+
+      if(!message.parse(messageText))
+      {
+        writeLspMessage("{\"jsonrpc\":\"2.0\",\"id\":null,"
+                        "\"error\":{\"code\":-32700,\"message\":\"Parse error\"}}");
+        continue;
+      }
+
+      const ASJsonValue& id = message.getMember("id");
+      const std::string& method = message.getMember("method").getString();
+      const ASJsonValue& params = message.getMember("params");
+      const std::string& uri = params.getMember("textDocument").getMember("uri").getString();
+      std::string result;                 // JSON result of a request
+      std::int32_t errorCode = 0;         // JSON-RPC error code of a failed request
+      std::string errorMessage;           // message of a failed request
+
+      if(method == "initialize")
+      {
+        result = "{\"capabilities\":{"
+                 "\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                 "\"documentFormattingProvider\":true,"
+                 "\"documentRangeFormattingProvider\":true,"
+                 "\"documentOnTypeFormattingProvider\":"
+                 "{\"firstTriggerCharacter\":\"}\",\"moreTriggerCharacter\":[\";\",\"\\n\"]}},"
+                 "\"serverInfo\":{\"name\":\"Artistic Style\",\"version\":"
+                 + ASJsonValue::quote(g_version) + "}}";
+      }
+      else if(method == "shutdown")
+      {
+        isShutdown = true;
+        result = "null";
+      }
+      else if(method == "exit")
+      {
+        return isShutdown;
+      }
+      else if(method == "textDocument/didOpen")
+      {
+        ASLspDocument& document = documents[uri];
+        document.text = params.getMember("textDocument").getMember("text").getString();
+        document.isFormatted = false;
+      }
+      else if(method == "textDocument/didChange")
+      {
+        std::map<std::string, ASLspDocument>::iterator document = documents.find(uri);
+
+        if(document != documents.end())
+        {
+          applyLspChanges(document->second, params.getMember("contentChanges"));
+        }
+      }
+      else if(method == "textDocument/didClose")
+      {
+        documents.erase(uri);
+      }
+      else if(method == "textDocument/formatting"
+              || method == "textDocument/rangeFormatting"
+              || method == "textDocument/onTypeFormatting")
+      {
+        std::map<std::string, ASLspDocument>::iterator document = documents.find(uri);
+        std::size_t firstLine = 0;
+        std::size_t lastLine = std::string::npos;
+
+        if(method == "textDocument/rangeFormatting")
+        {
+          // a range ending at the start of a line does not include the line
+          const ASJsonValue& range = params.getMember("range");
+          firstLine = static_cast<std::size_t>(std::max<std::int64_t>(
+                                                 range.getMember("start").getMember("line").getInteger(), 0));
+          lastLine = static_cast<std::size_t>(std::max<std::int64_t>(
+                                                range.getMember("end").getMember("line").getInteger(), 0));
+
+          if(lastLine > firstLine && range.getMember("end").getMember("character").getInteger() == 0)
+          {
+            lastLine--;
+          }
+        }
+        else if(method == "textDocument/onTypeFormatting")
+        {
+          // a new line also formats the line that was ended
+          lastLine = static_cast<std::size_t>(std::max<std::int64_t>(
+                                                params.getMember("position").getMember("line").getInteger(), 0));
+          firstLine = lastLine;
+
+          if(params.getMember("ch").getString() == "\n" && firstLine > 0)
+          {
+            firstLine--;
+          }
+        }
+
+        if(document == documents.end())
+        {
+          result = "null";
+        }
+        else if(!getLspEdits(uri, document->second, firstLine, lastLine, result))
+        {
+          errorCode = -32603;
+          errorMessage = "Checksum error in the formatted document";
+        }
+      }
+      else
+      {
+        errorCode = -32601;
+        errorMessage = "Method not found: " + method;
+      }
+
+      // notifications do not have a response
+      if(id.isNull())
+      {
+        continue;
+      }
+
+      if(errorCode != 0)
+      {
+        writeLspMessage("{\"jsonrpc\":\"2.0\",\"id\":" + id.getJson()
+                        + ",\"error\":{\"code\":" + std::to_string(errorCode)
+                        + ",\"message\":" + ASJsonValue::quote(errorMessage) + "}}");
+      }
+      else
+      {
+        writeLspMessage("{\"jsonrpc\":\"2.0\",\"id\":" + id.getJson()
+                        + ",\"result\":" + (result.empty() ? "null" : result) + "}");
+      }
     }
 
-    // if file has changed, write the new file
-    if(!filesAreIdentical || streamIterator.getLineEndChange(lineEndFormat))
+    return false;
+  }
+
+  /**
+   * Apply the content changes of a didChange notification to a document.
+   * A change without a range replaces the whole text.
+   */
+  void ASConsole::applyLspChanges(ASLspDocument& document, const ASJsonValue& contentChanges) const
+  {
+    const std::vector<ASJsonValue>& changes = contentChanges.getElements();
+
+    for(std::size_t i = 0; i < changes.size(); i++)
     {
-      writeFile(fileName_, encoding, out);
-      printMsg(_("Formatted  %s\n"), displayName);
-      filesFormatted++;
+      const ASJsonValue& range = changes[i].getMember("range");
+
+      if(range.isNull())
+      {
+        document.text = changes[i].getMember("text").getString();
+        continue;
+      }
+
+      std::size_t start = getLspOffset(document.text, range.getMember("start"));
+      std::size_t end = getLspOffset(document.text, range.getMember("end"));
+
+      if(end < start)
+      {
+        std::swap(start, end);
+      }
+
+      document.text.replace(start, end - start, changes[i].getMember("text").getString());
     }
-    else
+
+    document.isFormatted = false;
+  }
+
+  /**
+   * Get the edits that format a document as a JSON array of TextEdits.
+   * The whole document is formatted so the indent is correct, but only the
+   * edits that touch the lines from firstLine to lastLine are returned.
+   * The edits are the changed lines found by the same comparison as --diff.
+   *
+   * @param uri           The uri of the document, used for the language mode.
+   * @param document      The document, the formatted text is kept until it is changed.
+   * @param firstLine     The first line to be formatted.
+   * @param lastLine      The last line to be formatted.
+   * @param edits         Receives the JSON array of edits.
+   * @return              false if the formatted text failed the checksum verification.
+   */
+  bool ASConsole::getLspEdits(const std::string& uri, ASLspDocument& document,
+                              std::size_t firstLine, std::size_t lastLine, std::string& edits)
+  {
+    if(!document.isFormatted)
     {
-      if(!isFormattedOnly)
+      ASFileBuffer buffer;
+      buffer.fileName = uri;
+      appendInput(buffer, &document.text[0], document.text.length(), true);
+      formatBuffer(buffer);
+
+      if(!buffer.isVerified)
       {
-        printMsg(_("Unchanged  %s\n"), displayName);
+        return false;
       }
 
-      filesUnchanged++;
+      document.formattedText = buffer.out.str();
+      document.isFormatted = true;
+    }
+
+    // LSP lines end with LF, CRLF, or CR
+    ASLineDiff lineDiff(document.text, document.formattedText, true);
+    const std::vector<std::string_view>& origLines = lineDiff.getOrigLines();
+    const std::vector<std::string_view>& newLines = lineDiff.getNewLines();
+    const std::vector<ASLineEdit>& lineEdits = lineDiff.getEdits();
+    std::string newText;
+    edits = "[";
+
+    for(std::size_t i = 0; i < lineEdits.size(); i++)
+    {
+      const ASLineEdit& lineEdit = lineEdits[i];
+      std::size_t endLine = lineEdit.origLine + lineEdit.deleteCount;
+      std::size_t endCharacter = 0;
+
+      if(lineEdit.origLine > lastLine || endLine < firstLine)
+      {
+        continue;
+      }
+
+      // a last line without a line end is replaced up to its end
+      if(endLine == origLines.size() && endLine > 0
+          && origLines.back().back() != '\n' && origLines.back().back() != '\r')
+      {
+        endLine--;
+        endCharacter = Utf16Length(origLines.back().data(), origLines.back().length()) / 2;
+      }
+
+      newText.clear();
+
+      for(std::size_t j = lineEdit.newLine; j < lineEdit.newLine + lineEdit.insertCount; j++)
+      {
+        newText.append(newLines[j]);
+      }
+
+      if(edits.length() > 1)
+      {
+        edits += ',';
+      }
+
+      edits += "{\"range\":{\"start\":" + getLspPosition(lineEdit.origLine, 0)
+               + ",\"end\":" + getLspPosition(endLine, endCharacter)
+               + "},\"newText\":" + ASJsonValue::quote(newText) + "}";
+    }
+
+    edits += ']';
+    return true;
+  }
+
+  /**
+   * Get the offset in a document of an LSP position.
+   * The lines end with LF, CRLF, or CR, and the character is counted in UTF-16 units.
+   * A position past the end of a line or the document is moved back to the end.
+   */
+  std::size_t ASConsole::getLspOffset(const std::string& text, const ASJsonValue& position) const
+  {
+    std::int64_t line = position.getMember("line").getInteger();
+    std::int64_t character = position.getMember("character").getInteger();
+    std::size_t offset = 0;
+
+    for(; line > 0; line--)
+    {
+      while(offset < text.length() && text[offset] != '\n' && text[offset] != '\r')
+      {
+        offset++;
+      }
+
+      if(offset == text.length())
+      {
+        return offset;
+      }
+
+      if(text.compare(offset, 2, "\r\n") == 0)
+      {
+        offset++;
+      }
+
+      offset++;
+    }
+
+    while(character > 0 && offset < text.length()
+          && text[offset] != '\r' && text[offset] != '\n')
+    {
+      // a four byte UTF-8 character is a surrogate pair in UTF-16
+      character -= (static_cast<unsigned char>(text[offset]) >= 0xF0) ? 2 : 1;
+      offset++;
+
+      while(offset < text.length() && (text[offset] & 0xC0) == 0x80)
+      {
+        offset++;
+      }
+    }
+
+    return offset;
+  }
+
+// JSON text of an LSP position
+  std::string ASConsole::getLspPosition(std::size_t line, std::size_t character) const
+  {
+    return "{\"line\":" + std::to_string(line)
+           + ",\"character\":" + std::to_string(character) + "}";
+  }
+
+  /**
+   * Read a language server message from the standard input.
+   * The headers end with an empty line, only the Content-Length header is used.
+   * A length that is not a number or is too large is rejected. The content is
+   * skipped and the message is returned empty.
+   *
+   * @param message       Receives the JSON content of the message.
+   * @return              false at the end of the input.
+   */
+  bool ASConsole::readLspMessage(std::string& message) const
+  {
+    const std::string lengthHeader = "Content-Length:";
+    const std::uint64_t maxContentLength = 1073741824;   // 1 GB
+    std::uint64_t contentLength = 0;
+    std::uint64_t skipLength = 0;      // length of rejected content
+    bool hasLength = false;
+    bool isLengthValid = false;
+    std::string header;
+
+    while(true)
+    {
+      std::int32_t ch;
+      header.clear();
+
+      while((ch = getc(stdin)) != EOF && ch != '\n')
+      {
+        header += static_cast<char>(ch);
+      }
+
+      if(ch == EOF)
+      {
+        return false;
+      }
+
+      if(!header.empty() && header[header.length() - 1] == '\r')
+      {
+        header.erase(header.length() - 1);
+      }
+
+      if(header.empty())
+      {
+        if(hasLength)
+        {
+          break;
+        }
+
+        continue;
+      }
+
+      // the header is found after the content of a message that was not skipped
+      std::size_t lengthPos = header.find(lengthHeader);
+
+      if(lengthPos != std::string::npos)
+      {
+        const char* lengthText = header.c_str() + lengthPos + lengthHeader.length();
+        char* lengthEnd;
+        errno = 0;
+        contentLength = std::strtoull(lengthText, &lengthEnd, 10);
+        // the content of an overflowed length cannot be skipped
+        bool isNumber = (lengthEnd != lengthText && errno != ERANGE
+                         && strchr(lengthText, '-') == nullptr);
+        errno = 0;
+        isLengthValid = (isNumber && contentLength <= maxContentLength);
+        skipLength = (isNumber && !isLengthValid) ? contentLength : 0;
+        hasLength = true;
+      }
+    }
+
+    message.clear();
+
+    if(!isLengthValid)
+    {
+      char skipData[4096];
+
+      while(skipLength > 0)
+      {
+        std::size_t skipSize = skipLength < sizeof(skipData) ? skipLength : sizeof(skipData);
+
+        if(fread(skipData, 1, skipSize, stdin) != skipSize)
+        {
+          return false;
+        }
+
+        skipLength -= skipSize;
+      }
+
+      return true;
     }
 
-    assert(formatter.getChecksumDiff() == 0);
+    message.resize(static_cast<std::size_t>(contentLength));
+    return fread(&message[0], 1, message.length(), stdin) == message.length();
+  }
+
+  /**
+   * Write a language server message to the standard output.
+   */
+  void ASConsole::writeLspMessage(const std::string& message) const
+  {
+    std::string header = "Content-Length: " + std::to_string(message.length()) + "\r\n\r\n";
+
+    if(fwrite(header.data(), 1, header.length(), stdout) != header.length()
+        || fwrite(message.data(), 1, message.length(), stdout) != message.length()
+        || fflush(stdout) != 0)
+    {
+      error(_("Cannot write the language server message"), "--lsp");
+    }
   }
 
 // build a std::vector of argv options
@@ -691,16 +3093,21 @@ namespace astyle
     return fileOptionsVector;
   }
 
-  std::int32_t ASConsole::getFilesUnchanged()
+  std::size_t ASConsole::getFilesUnchanged()
   {
     return filesUnchanged;
   }
 
-  std::int32_t ASConsole::getFilesFormatted()
+  std::size_t ASConsole::getFilesFormatted()
   {
     return filesFormatted;
   }
 
+  std::size_t ASConsole::getFilesNotVerified()
+  {
+    return filesNotVerified;
+  }
+
   bool ASConsole::getIgnoreExcludeErrors()
   {
     return ignoreExcludeErrors;
@@ -716,6 +3123,11 @@ namespace astyle
     return isFormattedOnly;
   }
 
+  bool ASConsole::getIsLsp()
+  {
+    return isLsp;
+  }
+
   std::string ASConsole::getLanguageID() const
   {
     return localizer.getLanguageID();
@@ -767,6 +3179,52 @@ namespace astyle
     return origSuffix;
   }
 
+// get the line end to write after an output line.
+// outputEOL is decided before formatting, currentEOL is the input line end.
+// a requested line end that differs from the input changes the file.
+  const char* ASConsole::getOutputEOL(LineEndFormat lineEndFormat, const char* currentEOL)
+  {
+    if(lineEndFormat == LINEEND_DEFAULT)
+    {
+      // no line end has been read yet
+      if(currentEOL[0] == '\0')
+      {
+        return currentEOL;
+      }
+    }
+    else if(strcmp(currentEOL, outputEOL) != 0)
+    {
+      filesAreIdentical = false;
+    }
+
+    return outputEOL;
+  }
+
+  /**
+   * Get the formatted text in the encoding of the input file.
+   * UTF-8 text is converted back to UTF-16 for a UTF-16 file.
+   *
+   * @param encoding      The encoding of the input file.
+   * @param text          The formatted text.
+   * @return              The data to be written.
+   */
+  std::string ASConsole::getOutputData(FileEncoding encoding, const std::string& text) const
+  {
+    if(encoding == UTF_16LE || encoding == UTF_16BE)
+    {
+      // convert utf-8 to utf-16
+      std::size_t utf16Size = Utf16Length(text.c_str(), text.length());
+      char* utf16Out = new char[utf16Size];
+      std::size_t utf16Len = Utf8ToUtf16(const_cast<char*>(text.c_str()), text.length(), encoding, utf16Out);
+      assert(utf16Len == utf16Size);
+      std::string data(utf16Out, utf16Len);
+      delete []utf16Out;
+      return data;
+    }
+
+    return text;
+  }
+
   std::string ASConsole::getParam(const std::string& arg, const char* op)
   {
     return arg.substr(strlen(op));
@@ -778,16 +3236,20 @@ namespace astyle
   }
 
 // initialize output end of line
-  void ASConsole::initializeOutputEOL(LineEndFormat lineEndFormat)
+  void ASConsole::initializeOutputEOL(LineEndFormat lineEndFormat, const ASFileBuffer& buffer)
   {
+    std::size_t eolWindows = buffer.eolWindows;
+    std::size_t eolLinux = buffer.eolLinux;
+    std::size_t eolMacOld = buffer.eolMacOld;
+
     assert(lineEndFormat == LINEEND_DEFAULT
            || lineEndFormat == LINEEND_WINDOWS
            || lineEndFormat == LINEEND_LINUX
            || lineEndFormat == LINEEND_MACOLD);
 
     outputEOL[0] = '\0';    // current line end
-    prevEOL[0] = '\0';      // previous line end
-    lineEndsMixed = false;    // output has mixed line ends, LINEEND_DEFAULT only
+    // input has mixed line ends, LINEEND_DEFAULT only
+    lineEndsMixed = ((eolWindows != 0) + (eolLinux != 0) + (eolMacOld != 0) > 1);
 
     if(lineEndFormat == LINEEND_WINDOWS)
     {
@@ -801,29 +3263,85 @@ namespace astyle
     {
       strcpy(outputEOL, "\r");
     }
+    // use the majority of the input line ends, the same as ASStreamIterator
+    else if(eolWindows >= eolLinux)
+    {
+      if(eolWindows >= eolMacOld)
+      {
+        strcpy(outputEOL, "\r\n");  // Windows (CR+LF)
+      }
+      else
+      {
+        strcpy(outputEOL, "\r");  // MacOld (CR)
+      }
+    }
+    else if(eolLinux >= eolMacOld)
+    {
+      strcpy(outputEOL, "\n");  // Linux (LF)
+    }
     else
     {
-      outputEOL[0] = '\0';
+      strcpy(outputEOL, "\r");  // MacOld (CR)
     }
   }
 
 
-  FileEncoding ASConsole::readFile(const std::string& fileName_, std::stringstream& in) const
+  /**
+   * Append a block of data to the input text of a buffer.
+   * UTF-16 data is converted to UTF-8 and the line ends are counted.
+   * The buffer encoding must be set before the first block.
+   *
+   * @param buffer        The buffer for the input text.
+   * @param data          The block of data in the buffer encoding.
+   * @param dataSize      The size of the data.
+   * @param firstBlock    The data is the beginning of the file.
+   */
+  void ASConsole::appendInput(ASFileBuffer& buffer, char* data, std::size_t dataSize, bool firstBlock) const
+  {
+    FileEncoding encoding = buffer.encoding;
+
+    if(encoding == UTF_16LE || encoding == UTF_16BE)
+    {
+      // convert utf-16 to utf-8
+      std::size_t utf8Size = Utf8Length(data, dataSize, encoding);
+      char* utf8Out = new char[utf8Size];
+      std::size_t utf8Len = Utf16ToUtf8(data, dataSize, encoding, firstBlock, utf8Out);
+      assert(utf8Len == utf8Size);
+      buffer.in << std::string(utf8Out, utf8Len);
+      countLineEnds(utf8Out, utf8Len, buffer);
+      delete []utf8Out;
+    }
+    else
+    {
+      buffer.in << std::string(data, dataSize);
+      countLineEnds(data, dataSize, buffer);
+    }
+  }
+
+  void ASConsole::readFile(ASFileBuffer& buffer) const
   {
+    const std::string& fileName_ = buffer.fileName;
     const std::int32_t blockSize = 131072;  // 128 KB
+    const std::streamoff streamedFileSize = 268435456;  // 256 MB
     std::ifstream fin(fileName_.c_str(), std::ios::binary);
 
     if(!fin)
     {
-      error("Cannot open input file", fileName_.c_str());
+      fileError(buffer, "Cannot open input file", fileName_.c_str());
+      return;
     }
 
+    fin.seekg(0, std::ios::end);
+    std::streamoff fileSize = fin.tellg();
+    fin.seekg(0, std::ios::beg);
+
     char data[blockSize];
     fin.read(data, sizeof(data));
 
     if(fin.bad())
     {
-      error("Cannot read input file", fileName_.c_str());
+      fileError(buffer, "Cannot read input file", fileName_.c_str());
+      return;
     }
 
     std::size_t dataSize = static_cast<std::size_t>(fin.gcount());
@@ -831,33 +3349,33 @@ namespace astyle
 
     if(encoding ==  UTF_32BE || encoding ==  UTF_32LE)
     {
-      error(_("Cannot process UTF-32 encoding"), fileName_.c_str());
+      fileError(buffer, _("Cannot process UTF-32 encoding"), fileName_.c_str());
+      return;
     }
 
     bool firstBlock = true;
+    buffer.encoding = encoding;
+    // a large 8 bit file is formatted from the disk by the format stage
+    // only the line ends are counted, to choose the output line end
+    buffer.isStreamed = (encoding == ENCODING_8BIT && !isDiff && fileSize >= streamedFileSize);
 
     while(dataSize)
     {
-      if(encoding == UTF_16LE || encoding == UTF_16BE)
+      if(buffer.isStreamed)
       {
-        // convert utf-16 to utf-8
-        std::size_t utf8Size = Utf8Length(data, dataSize, encoding);
-        char* utf8Out = new char[utf8Size];
-        std::size_t utf8Len = Utf16ToUtf8(data, dataSize, encoding, firstBlock, utf8Out);
-        assert(utf8Len == utf8Size);
-        in << std::string(utf8Out, utf8Len);
-        delete []utf8Out;
+        countLineEnds(data, dataSize, buffer);
       }
       else
       {
-        in << std::string(data, dataSize);
+        appendInput(buffer, data, dataSize, firstBlock);
       }
 
       fin.read(data, sizeof(data));
 
       if(fin.bad())
       {
-        error("Cannot read input file", fileName_.c_str());
+        fileError(buffer, "Cannot read input file", fileName_.c_str());
+        return;
       }
 
       dataSize = static_cast<std::size_t>(fin.gcount());
@@ -865,7 +3383,21 @@ namespace astyle
     }
 
     fin.close();
-    return encoding;
+  }
+
+  void ASConsole::setChangedSince(std::string revision)
+  {
+    changedSince = revision;
+  }
+
+  void ASConsole::setErrorStream(std::ostream* stream)
+  {
+    errorStream = stream;
+  }
+
+  void ASConsole::setFilesFrom(std::string listName)
+  {
+    filesFrom = listName;
   }
 
   void ASConsole::setIgnoreExcludeErrors(bool state)
@@ -879,11 +3411,21 @@ namespace astyle
     ignoreExcludeErrorsDisplay = state;
   }
 
+  void ASConsole::setIsDiff(bool state)
+  {
+    isDiff = state;
+  }
+
   void ASConsole::setIsFormattedOnly(bool state)
   {
     isFormattedOnly = state;
   }
 
+  void ASConsole::setIsLsp(bool state)
+  {
+    isLsp = state;
+  }
+
   void ASConsole::setIsQuiet(bool state)
   {
     isQuiet = state;
@@ -894,11 +3436,21 @@ namespace astyle
     isRecursive = state;
   }
 
+  void ASConsole::setIsTar(bool state)
+  {
+    isTar = state;
+  }
+
   void ASConsole::setIsVerbose(bool state)
   {
     isVerbose = state;
   }
 
+  void ASConsole::setIsWatch(bool state)
+  {
+    isWatch = state;
+  }
+
   void ASConsole::setNoBackup(bool state)
   {
     noBackup = state;
@@ -924,37 +3476,41 @@ namespace astyle
     preserveDate = state;
   }
 
-// set outputEOL variable
-  void ASConsole::setOutputEOL(LineEndFormat lineEndFormat, const char* currentEOL)
-  {
-    if(lineEndFormat == LINEEND_DEFAULT)
-    {
-      strcpy(outputEOL, currentEOL);
+#ifdef _WIN32  // Windows specific
 
-      if(strlen(prevEOL) == 0)
-      {
-        strcpy(prevEOL, outputEOL);
-      }
+  /**
+   * WINDOWS function to create a temporary output file.
+   * A temporary file is not used. The output file is written in place
+   * after the backup is created.
+   *
+   * @return              An empty string.
+   */
+  std::string ASConsole::createTempFile(const std::string&) const
+  {
+    return std::string();
+  }
 
-      if(strcmp(prevEOL, outputEOL) != 0)
-      {
-        lineEndsMixed = true;
-        filesAreIdentical = false;
-        strcpy(prevEOL, outputEOL);
-      }
-    }
-    else
-    {
-      strcpy(prevEOL, currentEOL);
+  /**
+   * WINDOWS function to create a temporary file that is copied back into a file.
+   * The file must not exist, an existing file of the same name is not replaced.
+   *
+   * @param fileName_     The path and name of the file to be copied back.
+   * @return              The name of the temporary file, or an empty string if it cannot be created.
+   */
+  std::string ASConsole::createCopyTempFile(const std::string& fileName_) const
+  {
+    std::string tempName = fileName_ + ".astyle-tmp";
+    int fd = _open(tempName.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
 
-      if(strcmp(prevEOL, outputEOL) != 0)
-      {
-        filesAreIdentical = false;
-      }
+    if(fd == -1)
+    {
+      errno = 0;
+      return std::string();
     }
-  }
 
-#ifdef _WIN32  // Windows specific
+    _close(fd);
+    return tempName;
+  }
 
   /**
    * WINDOWS function to display the last system error.
@@ -973,7 +3529,7 @@ namespace astyle
       nullptr
     );
     // Display the std::string.
-    (*_err) << "Error (" << lastError << ") " << msgBuf << std::endl;
+    (*errorStream) << "Error (" << lastError << ") " << msgBuf << std::endl;
     // Free the buffer.
     LocalFree(msgBuf);
   }
@@ -1105,7 +3661,7 @@ namespace astyle
    * @param lcid    The LCID of the locale to be used for testing.
    * @return      The formatted number.
    */
-  std::string ASConsole::getNumberFormat(std::int32_t num, std::size_t lcid) const
+  std::string ASConsole::getNumberFormat(std::size_t num, std::size_t lcid) const
   {
     // Compilers that don't support C++ locales should still support this assert.
     // The C locale should be set but not the C++.
@@ -1165,8 +3721,132 @@ namespace astyle
     return formattedNum;
   }
 
+  /**
+   * WINDOWS function to start reading a file before it is formatted.
+   * This is not done on Windows.
+   */
+  void ASConsole::prefetchFile(const std::string& fileName_) const
+  {
+    (void) fileName_;
+  }
+
+  /**
+   * WINDOWS function to buffer the standard output when it is not a console.
+   * The file messages are then written in large blocks instead of a write for each file.
+   * Must be called before anything is written to the standard output.
+   */
+  void ASConsole::setOutputBuffering() const
+  {
+    if(!_isatty(_fileno(stdout)))
+    {
+      setvbuf(stdout, nullptr, _IOFBF, 65536);
+    }
+  }
+
+  /**
+   * WINDOWS function to watch the files for changes.
+   * The watch option is not available on Windows.
+   */
+  void ASConsole::watchFiles()
+  {
+    error(_("Cannot watch files"), "--watch");
+  }
+
 #else  // not _WIN32
 
+  /**
+   * LINUX function to create a temporary output file in the directory of a file.
+   * The temporary file replaces the file with rename(), which is atomic.
+   * It is created with the owner, group, and permissions of the file.
+   * A file that is a symbolic link or has other hard links is written
+   * in place so the links are not broken.
+   *
+   * @param fileName_     The path and name of the file to be replaced.
+   * @return              The name of the temporary file, or an empty string if not used.
+   */
+  std::string ASConsole::createTempFile(const std::string& fileName_) const
+  {
+#ifdef __VMS
+    return std::string();
+#else
+    struct stat stBuf;
+
+    if(lstat(fileName_.c_str(), &stBuf) != 0
+        || !S_ISREG(stBuf.st_mode)
+        || stBuf.st_nlink != 1)
+    {
+      errno = 0;
+      return std::string();
+    }
+
+    std::string tempTemplate = fileName_ + ".astyle-XXXXXX";
+    std::vector<char> tempName(tempTemplate.begin(), tempTemplate.end());
+    tempName.push_back('\0');
+    std::int32_t fd = mkstemp(&tempName[0]);
+
+    if(fd == -1)
+    {
+      errno = 0;
+      return std::string();
+    }
+
+    // the temporary file must have the owner, group, and permissions of the file
+    // they cannot be set for a file owned by another user, so it is written in place
+    if(fchown(fd, stBuf.st_uid, stBuf.st_gid) != 0
+        || fchmod(fd, stBuf.st_mode & 07777) != 0)
+    {
+      close(fd);
+      remove(&tempName[0]);
+      errno = 0;
+      return std::string();
+    }
+
+    close(fd);
+    errno = 0;
+    return std::string(&tempName[0]);
+#endif
+  }
+
+  /**
+   * LINUX function to create a temporary file that is copied back into a file.
+   * It is used for a file that cannot be replaced by a rename. The file is
+   * created with a unique name, so an existing file or a symbolic link is
+   * never written. The permissions are not set because the data is copied.
+   *
+   * @param fileName_     The path and name of the file to be copied back.
+   * @return              The name of the temporary file, or an empty string if it cannot be created.
+   */
+  std::string ASConsole::createCopyTempFile(const std::string& fileName_) const
+  {
+#ifdef __VMS
+    std::string tempName = fileName_ + ".astyle-tmp";
+    int fd = open(tempName.c_str(), O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if(fd == -1)
+    {
+      errno = 0;
+      return std::string();
+    }
+
+    close(fd);
+    return tempName;
+#else
+    std::string tempTemplate = fileName_ + ".astyle-XXXXXX";
+    std::vector<char> tempName(tempTemplate.begin(), tempTemplate.end());
+    tempName.push_back('\0');
+    std::int32_t fd = mkstemp(&tempName[0]);
+
+    if(fd == -1)
+    {
+      errno = 0;
+      return std::string();
+    }
+
+    close(fd);
+    return std::string(&tempName[0]);
+#endif
+  }
+
   /**
    * LINUX function to get the current directory.
    * This is done if the fileName does not contain a path.
@@ -1221,12 +3901,6 @@ namespace astyle
 
       if(stat(entryFilepath.c_str(), &statbuf) != 0)
       {
-        if(errno == EOVERFLOW)          // file over 2 GB is OK
-        {
-          errno = 0;
-          continue;
-        }
-
         perror("errno message");
         error("Error getting file status in directory", directory.c_str());
       }
@@ -1308,7 +3982,7 @@ namespace astyle
    * @param      For compatability with the Windows function.
    * @return      The formatted number.
    */
-  std::string ASConsole::getNumberFormat(std::int32_t num, std::size_t) const
+  std::string ASConsole::getNumberFormat(std::size_t num, std::size_t) const
   {
     // Compilers that don't support C++ locales should still support this assert.
     // The C locale should be set but not the C++.
@@ -1332,7 +4006,7 @@ namespace astyle
    * @param  separator  The thousands group separator from the locale.
    * @return        The formatted number.
    */
-  std::string ASConsole::getNumberFormat(std::int32_t num, const char* groupingArg, const char* separator) const
+  std::string ASConsole::getNumberFormat(std::size_t num, const char* groupingArg, const char* separator) const
   {
     // convert num to a std::string
     stringstream alphaNum;
@@ -1350,45 +4024,399 @@ namespace astyle
       grouping = number.length();
     }
 
-    while(i > 0)
-    {
-      // extract a group of numbers
-      std::string group;
+    while(i > 0)
+    {
+      // extract a group of numbers
+      std::string group;
+
+      if(i < grouping)
+      {
+        group = number.substr(0);
+      }
+      else
+      {
+        group = number.substr(i - grouping);
+      }
+
+      // update formatted number
+      formattedNum.insert(0, group);
+      i -= grouping;
+
+      if(i < 0)
+      {
+        i = 0;
+      }
+
+      if(i > 0)
+      {
+        formattedNum.insert(0, separator);
+      }
+
+      number.erase(i);
+
+      // update grouping
+      if(groupingArg[ig] != '\0'
+          && groupingArg[ig + 1] != '\0')
+      {
+        grouping = groupingArg[++ig];
+      }
+    }
+
+    return formattedNum;
+  }
+
+  /**
+   * LINUX function to start reading a file before it is formatted.
+   * posix_fadvise starts an asynchronous read into the page cache,
+   * so the reads of the following files overlap with the formatting.
+   * It does nothing if the file cannot be opened.
+   */
+  void ASConsole::prefetchFile(const std::string& fileName_) const
+  {
+#ifdef __linux__
+    std::int32_t fd = open(fileName_.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(fd != -1)
+    {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+      close(fd);
+    }
+
+    errno = 0;
+#else
+    (void) fileName_;
+#endif
+  }
+
+  /**
+   * LINUX function to buffer the standard output when it is not a terminal.
+   * The file messages are then written in large blocks instead of a write for each file.
+   * Must be called before anything is written to the standard output.
+   */
+  void ASConsole::setOutputBuffering() const
+  {
+    if(!isatty(STDOUT_FILENO))
+    {
+      setvbuf(stdout, nullptr, _IOFBF, 65536);
+    }
+  }
+
+  /**
+   * Check if a file in a watched directory must be formatted by watchFiles().
+   * The file must match a file name entry and not be a backup or excluded.
+   *
+   * @param watchBase       The directory of each file name entry.
+   * @param watchWildcard   The wildcard of each file name entry.
+   * @param directory       The directory of the file.
+   * @param name            The name of the file.
+   * @return                true if the file is watched.
+   */
+  bool ASConsole::isWatchedFile(const std::vector<std::string>& watchBase,
+                                const std::vector<std::string>& watchWildcard,
+                                const std::string& directory, const char* name)
+  {
+    std::string entryFilepath = directory + g_fileSeparator + name;
+    bool isMatch = false;
+
+    for(std::size_t i = 0; i < watchBase.size() && !isMatch; i++)
+    {
+      if(directory == watchBase[i]
+          || (isRecursive
+              && directory.compare(0, watchBase[i].length() + 1, watchBase[i] + g_fileSeparator) == 0))
+      {
+        isMatch = wildcmp(watchWildcard[i].c_str(), name) != 0;
+      }
+    }
+
+    return (isMatch
+            && !stringEndsWith(entryFilepath, origSuffix)
+            && !isPathExclued(entryFilepath));
+  }
+
+  /**
+   * LINUX function to watch the files for changes and format them when they are saved.
+   * inotify watches are added to the directory of each file name entry, and to the
+   * sub directories if recursive. A burst of events is collected until there are no
+   * events for the debounce time, then the changed files are formatted with the
+   * same formatter. The events from writing the formatted files are ignored.
+   * If the event queue overflows, the watched directories are scanned again.
+   */
+  void ASConsole::watchFiles()
+  {
+#ifdef __linux__
+    const std::int32_t debounceTime = 200;    // milliseconds
+    std::vector<std::string> watchBase;       // directory of each file name entry
+    std::vector<std::string> watchWildcard;   // wildcard of each file name entry
+    std::map<std::int32_t, std::string> watchDirectory;   // directory of each watch
+    std::map<std::string, struct stat> writtenFile;       // status after formatting
+    std::set<std::string> changedFile;        // files waiting for the debounce time
+    std::vector<std::string> subDirectory;    // directories to be watched
+
+    std::int32_t inotifyFd = inotify_init1(IN_CLOEXEC);
+
+    if(inotifyFd == -1)
+    {
+      error(_("Cannot watch files"), "inotify");
+    }
+
+    const std::uint32_t watchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    for(std::size_t i = 0; i < fileNameVector.size(); i++)
+    {
+      std::size_t separator = fileNameVector[i].find_last_of(g_fileSeparator);
+
+      if(separator == std::string::npos)
+      {
+        watchBase.push_back(getCurrentDirectory(fileNameVector[i]));
+        watchWildcard.push_back(fileNameVector[i]);
+      }
+      else
+      {
+        watchBase.push_back(fileNameVector[i].substr(0, separator));
+        watchWildcard.push_back(fileNameVector[i].substr(separator + 1));
+      }
+
+      subDirectory.push_back(watchBase.back());
+    }
+
+    // watch the directories, this uses the same rules as getFileNames
+    while(!subDirectory.empty())
+    {
+      std::string directory = subDirectory.back();
+      subDirectory.pop_back();
+      std::int32_t wd = inotify_add_watch(inotifyFd, directory.c_str(), watchMask);
+
+      if(wd == -1)
+      {
+        error(_("Cannot watch directory"), directory.c_str());
+      }
+
+      watchDirectory[wd] = directory;
+
+      if(!isRecursive)
+      {
+        continue;
+      }
+
+      DIR* dp = opendir(directory.c_str());
+
+      if(dp == nullptr)
+      {
+        error(_("Cannot open directory"), directory.c_str());
+      }
+
+      struct dirent* entry;
+      struct stat statbuf;
+
+      while((entry = readdir(dp)) != nullptr)
+      {
+        std::string entryFilepath = directory + g_fileSeparator + entry->d_name;
+
+        if(entry->d_name[0] != '.'
+            && stat(entryFilepath.c_str(), &statbuf) == 0
+            && S_ISDIR(statbuf.st_mode)
+            && !isPathExclued(entryFilepath))
+        {
+          subDirectory.push_back(entryFilepath);
+        }
+      }
+
+      closedir(dp);
+    }
+
+    // the file names are displayed with the full path
+    hasWildcard = false;
+    printMsg(_("Watching  %s\n"), _("press Ctrl-C to stop"));
+    fflush(stdout);
+    errno = 0;
+
+    // the event buffer must be aligned for struct inotify_event
+    alignas(struct inotify_event) char eventBuffer[65536];
+    struct pollfd inotifyPoll;
+    inotifyPoll.fd = inotifyFd;
+    inotifyPoll.events = POLLIN;
+
+    while(true)
+    {
+      // wait for an event, or for the debounce time if files have changed
+      std::int32_t ready = poll(&inotifyPoll, 1, changedFile.empty() ? -1 : debounceTime);
+
+      if(ready == -1)
+      {
+        if(errno == EINTR)
+        {
+          errno = 0;
+          continue;
+        }
+
+        error(_("Cannot watch files"), "poll");
+      }
+
+      // no events for the debounce time, format the changed files
+      if(ready == 0)
+      {
+        for(std::set<std::string>::iterator changed = changedFile.begin(); changed != changedFile.end(); ++changed)
+        {
+          struct stat statbuf;
+
+          if(stat(changed->c_str(), &statbuf) != 0 || !S_ISREG(statbuf.st_mode))
+          {
+            errno = 0;
+            continue;
+          }
+
+          // ignore the event from writing a formatted file
+          std::map<std::string, struct stat>::iterator written = writtenFile.find(*changed);
+
+          if(written != writtenFile.end()
+              && written->second.st_ino == statbuf.st_ino
+              && written->second.st_size == statbuf.st_size
+              && written->second.st_mtim.tv_sec == statbuf.st_mtim.tv_sec
+              && written->second.st_mtim.tv_nsec == statbuf.st_mtim.tv_nsec)
+          {
+            continue;
+          }
+
+          formatFile(*changed);
+
+          if(stat(changed->c_str(), &statbuf) == 0)
+          {
+            writtenFile[*changed] = statbuf;
+          }
+
+          errno = 0;
+        }
+
+        changedFile.clear();
+        fflush(stdout);
+        continue;
+      }
+
+      ssize_t length = read(inotifyFd, eventBuffer, sizeof(eventBuffer));
+
+      if(length <= 0)
+      {
+        error(_("Cannot watch files"), "read");
+      }
+
+      for(char* next = eventBuffer; next < eventBuffer + length;)
+      {
+        struct inotify_event* event = reinterpret_cast<struct inotify_event*>(next);
+        next += sizeof(struct inotify_event) + event->len;
+
+        // events were lost, scan the watched directories for the files
+        if(event->mask & IN_Q_OVERFLOW)
+        {
+          std::set<std::string> scannedDirectory;
+
+          for(std::map<std::int32_t, std::string>::iterator watched = watchDirectory.begin();
+              watched != watchDirectory.end(); ++watched)
+          {
+            scannedDirectory.insert(watched->second);
+            subDirectory.push_back(watched->second);
+          }
+
+          while(!subDirectory.empty())
+          {
+            std::string directory = subDirectory.back();
+            subDirectory.pop_back();
+            DIR* dp = opendir(directory.c_str());
+
+            if(dp == nullptr)
+            {
+              errno = 0;
+              continue;
+            }
+
+            struct dirent* entry;
+            struct stat statbuf;
+
+            while((entry = readdir(dp)) != nullptr)
+            {
+              std::string entryFilepath = directory + g_fileSeparator + entry->d_name;
+
+              if(entry->d_name[0] == '.' || stat(entryFilepath.c_str(), &statbuf) != 0)
+              {
+                continue;
+              }
+
+              // a sub directory created with the lost events is watched and scanned
+              if(S_ISDIR(statbuf.st_mode))
+              {
+                if(isRecursive
+                    && scannedDirectory.count(entryFilepath) == 0
+                    && !isPathExclued(entryFilepath))
+                {
+                  std::int32_t wd = inotify_add_watch(inotifyFd, entryFilepath.c_str(), watchMask);
+
+                  if(wd != -1)
+                  {
+                    watchDirectory[wd] = entryFilepath;
+                    scannedDirectory.insert(entryFilepath);
+                    subDirectory.push_back(entryFilepath);
+                  }
+                }
+              }
+              else if(S_ISREG(statbuf.st_mode)
+                      && isWatchedFile(watchBase, watchWildcard, directory, entry->d_name))
+              {
+                changedFile.insert(entryFilepath);
+              }
+            }
+
+            closedir(dp);
+            errno = 0;
+          }
+
+          continue;
+        }
+
+        if(event->mask & IN_IGNORED)
+        {
+          watchDirectory.erase(event->wd);
+          continue;
+        }
+
+        std::map<std::int32_t, std::string>::iterator directory = watchDirectory.find(event->wd);
 
-      if(i < grouping)
-      {
-        group = number.substr(0);
-      }
-      else
-      {
-        group = number.substr(i - grouping);
-      }
+        if(event->len == 0 || directory == watchDirectory.end() || event->name[0] == '.')
+        {
+          continue;
+        }
 
-      // update formatted number
-      formattedNum.insert(0, group);
-      i -= grouping;
+        std::string entryFilepath = directory->second + g_fileSeparator + event->name;
 
-      if(i < 0)
-      {
-        i = 0;
-      }
+        // watch a new sub directory
+        if(event->mask & IN_ISDIR)
+        {
+          if(isRecursive && (event->mask & IN_CREATE) && !isPathExclued(entryFilepath))
+          {
+            std::int32_t wd = inotify_add_watch(inotifyFd, entryFilepath.c_str(), watchMask);
 
-      if(i > 0)
-      {
-        formattedNum.insert(0, separator);
-      }
+            if(wd != -1)
+            {
+              watchDirectory[wd] = entryFilepath;
+            }
+          }
 
-      number.erase(i);
+          continue;
+        }
 
-      // update grouping
-      if(groupingArg[ig] != '\0'
-          && groupingArg[ig + 1] != '\0')
-      {
-        grouping = groupingArg[++ig];
+        // a new file is formatted when it is closed
+        if(event->mask & IN_CREATE)
+        {
+          continue;
+        }
+
+        if(isWatchedFile(watchBase, watchWildcard, directory->second, event->name))
+        {
+          changedFile.insert(entryFilepath);
+        }
       }
     }
-
-    return formattedNum;
+#else
+    error(_("Cannot watch files"), "--watch");
+#endif  // __linux__
   }
 
 #endif  // _WIN32
@@ -1531,6 +4559,11 @@ namespace astyle
     }
   }
 
+  bool ASConsole::fileListIsEmpty()
+  {
+    return filesFrom.empty() && changedSince.empty() && !isTar;
+  }
+
   bool ASConsole::fileNameVectorIsEmpty()
   {
     return fileNameVector.empty();
@@ -1564,6 +4597,40 @@ namespace astyle
 // used for both directories and filenames
 // updates the g_excludeHitsVector
 // return true if a match
+// check a file path and each of its directories for an exclude
+  bool ASConsole::isFilePathExcluded(const std::string& filePath)
+  {
+    bool isExcluded = isPathExclued(filePath);
+
+    for(std::size_t i = filePath.find(g_fileSeparator, 1);
+        i != std::string::npos && !isExcluded;
+        i = filePath.find(g_fileSeparator, i + 1))
+    {
+      isExcluded = isPathExclued(filePath.substr(0, i));
+    }
+
+    return isExcluded;
+  }
+
+// check that a command line file path is an existing file without a wildcard
+// getFilePaths() will accept it without displaying a message
+  bool ASConsole::isSingleFilePath(const std::string& filePath) const
+  {
+    std::size_t nameStart = filePath.find_last_of(g_fileSeparator);
+    nameStart = (nameStart == std::string::npos) ? 0 : nameStart + 1;
+
+    if(nameStart == filePath.length()
+        || filePath.find_first_of("*?", nameStart) != std::string::npos
+        || isRecursive
+        || !excludeVector.empty())
+    {
+      return false;
+    }
+
+    struct stat statbuf;
+    return (stat(filePath.c_str(), &statbuf) == 0 && (statbuf.st_mode & S_IFREG));
+  }
+
   bool ASConsole::isPathExclued(const std::string& subPath)
   {
     bool retVal = false;
@@ -1621,357 +4688,383 @@ namespace astyle
 
   void ASConsole::printHelp() const
   {
-    (*_err) << std::endl;
-    (*_err) << "                            Artistic Style " << g_version << std::endl;
-    (*_err) << "                         Maintained by: Jim Pattee\n";
-    (*_err) << "                       Original Author: Tal Davidson\n";
-    (*_err) << std::endl;
-    (*_err) << "Usage  :  astyle [options] Source1.cpp Source2.cpp  [...]\n";
-    (*_err) << "          astyle [options] < Original > Beautified\n";
-    (*_err) << std::endl;
-    (*_err) << "When indenting a specific file, the resulting indented file RETAINS the\n";
-    (*_err) << "original file-name. The original pre-indented file is renamed, with a\n";
-    (*_err) << "suffix of \".orig\" added to the original filename.\n";
-    (*_err) << std::endl;
-    (*_err) << "Wildcards (* and ?) may be used in the filename.\n";
-    (*_err) << "A \'recursive\' option can process directories recursively.\n";
-    (*_err) << std::endl;
-    (*_err) << "By default, astyle is set up to indent C/C++/C#/Java files, with four\n";
-    (*_err) << "spaces per indent, a maximal indentation of 40 spaces inside continuous\n";
-    (*_err) << "statements, a minimum indentation of eight spaces inside conditional\n";
-    (*_err) << "statements, and NO formatting options.\n";
-    (*_err) << std::endl;
-    (*_err) << "Option's Format:\n";
-    (*_err) << "----------------\n";
-    (*_err) << "    Long options (starting with '--') must be written one at a time.\n";
-    (*_err) << "    Short options (starting with '-') may be appended together.\n";
-    (*_err) << "    Thus, -bps4 is the same as -b -p -s4.\n";
-    (*_err) << std::endl;
-    (*_err) << "Default options file:\n";
-    (*_err) << "---------------------\n";
-    (*_err) << "    Artistic Style looks for a default options file in the\n";
-    (*_err) << "    following order:\n";
-    (*_err) << "    1. The contents of the ARTISTIC_STYLE_OPTIONS environment\n";
-    (*_err) << "       variable if it exists.\n";
-    (*_err) << "    2. The file called .astylerc in the directory pointed to by the\n";
-    (*_err) << "       HOME environment variable ( i.e. $HOME/.astylerc ).\n";
-    (*_err) << "    3. The file called astylerc in the directory pointed to by the\n";
-    (*_err) << "       USERPROFILE environment variable ( i.e. %USERPROFILE%\\astylerc ).\n";
-    (*_err) << "    If a default options file is found, the options in this file\n";
-    (*_err) << "    will be parsed BEFORE the command-line options.\n";
-    (*_err) << "    Long options within the default option file may be written without\n";
-    (*_err) << "    the preliminary '--'.\n";
-    (*_err) << std::endl;
-    (*_err) << "Bracket Style Options:\n";
-    (*_err) << "----------------------\n";
-    (*_err) << "    --style=allman  OR  --style=ansi  OR  --style=bsd\n";
-    (*_err) << "      OR  --style=break  OR  -A1\n";
-    (*_err) << "    Allman style formatting/indenting.\n";
-    (*_err) << "    Broken brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=java  OR  --style=attach  OR  -A2\n";
-    (*_err) << "    Java style formatting/indenting.\n";
-    (*_err) << "    Attached brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=kr  OR  --style=k&r  OR  --style=k/r  OR  -A3\n";
-    (*_err) << "    Kernighan & Ritchie style formatting/indenting.\n";
-    (*_err) << "    Linux brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=stroustrup  OR  -A4\n";
-    (*_err) << "    Stroustrup style formatting/indenting.\n";
-    (*_err) << "    Stroustrup brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=whitesmith  OR  -A5\n";
-    (*_err) << "    Whitesmith style formatting/indenting.\n";
-    (*_err) << "    Broken, indented brackets.\n";
-    (*_err) << "    Indented class blocks and switch blocks.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=banner  OR  -A6\n";
-    (*_err) << "    Banner style formatting/indenting.\n";
-    (*_err) << "    Attached, indented brackets.\n";
-    (*_err) << "    Indented class blocks and switch blocks.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=gnu  OR  -A7\n";
-    (*_err) << "    GNU style formatting/indenting.\n";
-    (*_err) << "    Broken brackets, indented blocks.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=linux  OR  -A8\n";
-    (*_err) << "    Linux style formatting/indenting.\n";
-    (*_err) << "    Linux brackets, minimum conditional indent is one-half indent.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=horstmann  OR  -A9\n";
-    (*_err) << "    Horstmann style formatting/indenting.\n";
-    (*_err) << "    Run-in brackets, indented switches.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=1tbs  OR  --style=otbs  OR  -A10\n";
-    (*_err) << "    One True Brace Style formatting/indenting.\n";
-    (*_err) << "    Linux brackets, add brackets to all conditionals.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=pico  OR  -A11\n";
-    (*_err) << "    Pico style formatting/indenting.\n";
-    (*_err) << "    Run-in opening brackets and attached closing brackets.\n";
-    (*_err) << "    Uses keep one line blocks and keep one line statements.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --style=lisp  OR  -A12\n";
-    (*_err) << "    Lisp style formatting/indenting.\n";
-    (*_err) << "    Attached opening brackets and attached closing brackets.\n";
-    (*_err) << "    Uses keep one line statements.\n";
-    (*_err) << std::endl;
-    (*_err) << "Tab Options:\n";
-    (*_err) << "------------\n";
-    (*_err) << "    default indent option\n";
-    (*_err) << "    If no indentation option is set,\n";
-    (*_err) << "    the default option of 4 spaces will be used.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent=spaces=#  OR  -s#\n";
-    (*_err) << "    Indent using # spaces per indent. Not specifying #\n";
-    (*_err) << "    will result in a default of 4 spaces per indent.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent=tab  OR  --indent=tab=#  OR  -t  OR  -t#\n";
-    (*_err) << "    Indent using tab characters, assuming that each\n";
-    (*_err) << "    tab is # spaces long. Not specifying # will result\n";
-    (*_err) << "    in a default assumption of 4 spaces per tab.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent=force-tab=#  OR  -T#\n";
-    (*_err) << "    Indent using tab characters, assuming that each\n";
-    (*_err) << "    tab is # spaces long. Force tabs to be used in areas\n";
-    (*_err) << "    Astyle would prefer to use spaces.\n";
-    (*_err) << std::endl;
-    (*_err) << "Old Bracket Options (deprectaied):\n";
-    (*_err) << "----------------------------------\n";
-    (*_err) << "The following bracket options have been depreciated and\n";
-    (*_err) << "will be removed in a future release.\n";
-    (*_err) << "Use the above Bracket Style Options instead.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=break  OR  -b  (deprectaied)\n";
-    (*_err) << "    Break brackets from pre-block code (i.e. ANSI C/C++ style).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=attach  OR  -a  (deprectaied)\n";
-    (*_err) << "    Attach brackets to pre-block code (i.e. Java/K&R style).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=linux  OR  -l  (deprectaied)\n";
-    (*_err) << "    Break definition-block brackets and attach command-block\n";
-    (*_err) << "    brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=stroustrup  OR  -u  (deprectaied)\n";
-    (*_err) << "    Attach all brackets except function definition brackets.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=run-in  OR  -g  (deprectaied)\n";
-    (*_err) << "    Break brackets from pre-block code, but allow following\n";
-    (*_err) << "    run-in statements on the same line as an opening bracket.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --brackets=horstmann\n";
-    (*_err) << "    THIS IS NO LONGER A VALID OPTION.\n";
-    (*_err) << "    Use style=horstmann instead.\n";
-    (*_err) << std::endl;
-    (*_err) << "Indentation options:\n";
-    (*_err) << "--------------------\n";
-    (*_err) << "    --indent-classes  OR  -C\n";
-    (*_err) << "    Indent 'class' blocks, so that the inner 'public:',\n";
-    (*_err) << "    'protected:' and 'private: headers are indented in\n";
-    (*_err) << "    relation to the class block.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-switches  OR  -S\n";
-    (*_err) << "    Indent 'switch' blocks, so that the inner 'case XXX:'\n";
-    (*_err) << "    headers are indented in relation to the switch block.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-cases  OR  -K\n";
-    (*_err) << "    Indent case blocks from the 'case XXX:' headers.\n";
-    (*_err) << "    Case statements not enclosed in blocks are NOT indented.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-brackets  OR  -B\n";
-    (*_err) << "    THIS IS NO LONGER A VALID OPTION.\n";
-    (*_err) << "    Use style=whitesmith or style=banner instead.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-blocks  OR  -G\n";
-    (*_err) << "    THIS IS NO LONGER A VALID OPTION.\n";
-    (*_err) << "    Use style=gnu instead.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-namespaces  OR  -N\n";
-    (*_err) << "    Indent the contents of namespace blocks.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-labels  OR  -L\n";
-    (*_err) << "    Indent labels so that they appear one indent less than\n";
-    (*_err) << "    the current indentation level, rather than being\n";
-    (*_err) << "    flushed completely to the left (which is the default).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-preprocessor  OR  -w\n";
-    (*_err) << "    Indent multi-line #define statements.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --indent-col1-comments  OR  -Y\n";
-    (*_err) << "    Indent line comments that start in column one.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --min-conditional-indent=#  OR  -m#\n";
-    (*_err) << "    Indent a minimal # spaces in a continuous conditional\n";
-    (*_err) << "    belonging to a conditional header.\n";
-    (*_err) << "    The valid values are:\n";
-    (*_err) << "    0 - no minimal indent.\n";
-    (*_err) << "    1 - indent at least one additional indent.\n";
-    (*_err) << "    2 - indent at least two additional indents.\n";
-    (*_err) << "    3 - indent at least one-half an additional indent.\n";
-    (*_err) << "    The default value is 2, two additional indents.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --max-instatement-indent=#  OR  -M#\n";
-    (*_err) << "    Indent a maximal # spaces in a continuous statement,\n";
-    (*_err) << "    relative to the previous line.\n";
-    (*_err) << "    The valid values are 40 thru 120.\n";
-    (*_err) << "    The default value is 40.\n";
-    (*_err) << std::endl;
-    (*_err) << "Padding options:\n";
-    (*_err) << "--------------------\n";
-    (*_err) << "    --break-blocks  OR  -f\n";
-    (*_err) << "    Insert empty lines around unrelated blocks, labels, classes, ...\n";
-    (*_err) << std::endl;
-    (*_err) << "    --break-blocks=all  OR  -F\n";
-    (*_err) << "    Like --break-blocks, except also insert empty lines \n";
-    (*_err) << "    around closing headers (e.g. 'else', 'catch', ...).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --pad-oper  OR  -p\n";
-    (*_err) << "    Insert space paddings around operators.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --pad-paren  OR  -P\n";
-    (*_err) << "    Insert space padding around parenthesis on both the outside\n";
-    (*_err) << "    and the inside.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --pad-paren-out  OR  -d\n";
-    (*_err) << "    Insert space padding around parenthesis on the outside only.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --pad-paren-in  OR  -D\n";
-    (*_err) << "    Insert space padding around parenthesis on the inside only.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --pad-header  OR  -H\n";
-    (*_err) << "    Insert space padding after paren headers (e.g. 'if', 'for'...).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --unpad-paren  OR  -U\n";
-    (*_err) << "    Remove unnecessary space padding around parenthesis.  This\n";
-    (*_err) << "    can be used in combination with the 'pad' options above.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --delete-empty-lines  OR  -xd\n";
-    (*_err) << "    Delete empty lines within a function or method.\n";
-    (*_err) << "    It will NOT delete lines added by the break-blocks options.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --fill-empty-lines  OR  -E\n";
-    (*_err) << "    Fill empty lines with the white space of their\n";
-    (*_err) << "    previous lines.\n";
-    (*_err) << std::endl;
-    (*_err) << "Formatting options:\n";
-    (*_err) << "-------------------\n";
-    (*_err) << "    --break-closing-brackets  OR  -y\n";
-    (*_err) << "    Break brackets before closing headers (e.g. 'else', 'catch', ...).\n";
-    (*_err) << "    Use with --brackets=attach, --brackets=linux, \n";
-    (*_err) << "    or --brackets=stroustrup.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --break-elseifs  OR  -e\n";
-    (*_err) << "    Break 'else if()' statements into two different lines.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --add-brackets  OR  -j\n";
-    (*_err) << "    Add brackets to unbracketed one line conditional statements.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --add-one-line-brackets  OR  -J\n";
-    (*_err) << "    Add one line brackets to unbracketed one line conditional\n";
-    (*_err) << "    statements.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --keep-one-line-blocks  OR  -O\n";
-    (*_err) << "    Don't break blocks residing completely on one line.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --keep-one-line-statements  OR  -o\n";
-    (*_err) << "    Don't break lines containing multiple statements into\n";
-    (*_err) << "    multiple single-statement lines.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --convert-tabs  OR  -c\n";
-    (*_err) << "    Convert tabs to the appropriate number of spaces.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --align-pointer=type    OR  -k1\n";
-    (*_err) << "    --align-pointer=middle  OR  -k2\n";
-    (*_err) << "    --align-pointer=name    OR  -k3\n";
-    (*_err) << "    Attach a pointer or reference operator (* or &) to either\n";
-    (*_err) << "    the operator type (left), middle, or operator name (right).\n";
-    (*_err) << "    To align the reference separately use --align-reference.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --align-reference=none    OR  -W0\n";
-    (*_err) << "    --align-reference=type    OR  -W1\n";
-    (*_err) << "    --align-reference=middle  OR  -W2\n";
-    (*_err) << "    --align-reference=name    OR  -W3\n";
-    (*_err) << "    Attach a reference operator (&) to either\n";
-    (*_err) << "    the operator type (left), middle, or operator name (right).\n";
-    (*_err) << "    If not set, follow pointer alignment.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --mode=c\n";
-    (*_err) << "    Indent a C or C++ source file (this is the default).\n";
-    (*_err) << std::endl;
-    (*_err) << "    --mode=java\n";
-    (*_err) << "    Indent a Java source file.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --mode=cs\n";
-    (*_err) << "    Indent a C# source file.\n";
-    (*_err) << std::endl;
-    (*_err) << "Other options:\n";
-    (*_err) << "--------------\n";
-    (*_err) << "    --suffix=####\n";
-    (*_err) << "    Append the suffix #### instead of '.orig' to original filename.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --suffix=none  OR  -n\n";
-    (*_err) << "    Do not retain a backup of the original file.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --recursive  OR  -r  OR  -R\n";
-    (*_err) << "    Process subdirectories recursively.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --exclude=####\n";
-    (*_err) << "    Specify a file or directory #### to be excluded from processing.\n";
-    (*_err) << std::endl;
-    (*_err) << "    ignore-exclude-errors  OR  -i\n";
-    (*_err) << "    Allow processing to continue if there are errors in the exclude=###\n";
-    (*_err) << "    options. It will display the unmatched excludes.\n";
-    (*_err) << std::endl;
-    (*_err) << "    ignore-exclude-errors-x  OR  -xi\n";
-    (*_err) << "    Allow processing to continue if there are errors in the exclude=###\n";
-    (*_err) << "    options. It will NOT display the unmatched excludes.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --errors-to-stdout  OR  -X\n";
-    (*_err) << "    Print errors and help information to standard-output rather than\n";
-    (*_err) << "    to standard-error.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --preserve-date  OR  -Z\n";
-    (*_err) << "    The date and time modified will not be changed in the formatted file.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --verbose  OR  -v\n";
-    (*_err) << "    Verbose mode. Extra informational messages will be displayed.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --formatted  OR  -Q\n";
-    (*_err) << "    Formatted display mode. Display only the files that have been formatted.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --quiet  OR  -q\n";
-    (*_err) << "    Quiet mode. Suppress all output except error messages.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --lineend=windows  OR  -z1\n";
-    (*_err) << "    --lineend=linux    OR  -z2\n";
-    (*_err) << "    --lineend=macold   OR  -z3\n";
-    (*_err) << "    Force use of the specified line end style. Valid options\n";
-    (*_err) << "    are windows (CRLF), linux (LF), and macold (CR).\n";
-    (*_err) << std::endl;
-    (*_err) << "Command Line Only:\n";
-    (*_err) << "------------------\n";
-    (*_err) << "    --options=####\n";
-    (*_err) << "    Specify an options file #### to read and use.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --options=none\n";
-    (*_err) << "    Disable the default options file.\n";
-    (*_err) << "    Only the command-line parameters will be used.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --ascii  OR  -I\n";
-    (*_err) << "    The displayed output will be ascii characters only.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --version  OR  -V\n";
-    (*_err) << "    Print version number.\n";
-    (*_err) << std::endl;
-    (*_err) << "    --help  OR  -h  OR  -?\n";
-    (*_err) << "    Print this help message.\n";
-    (*_err) << std::endl;
-  }
-
-
-  /**
-   * Process files in the fileNameVector.
+    (*errorStream) << std::endl;
+    (*errorStream) << "                            Artistic Style " << g_version << std::endl;
+    (*errorStream) << "                         Maintained by: Jim Pattee\n";
+    (*errorStream) << "                       Original Author: Tal Davidson\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Usage  :  astyle [options] Source1.cpp Source2.cpp  [...]\n";
+    (*errorStream) << "          astyle [options] < Original > Beautified\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "When indenting a specific file, the resulting indented file RETAINS the\n";
+    (*errorStream) << "original file-name. The original pre-indented file is renamed, with a\n";
+    (*errorStream) << "suffix of \".orig\" added to the original filename.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Wildcards (* and ?) may be used in the filename.\n";
+    (*errorStream) << "A \'recursive\' option can process directories recursively.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "By default, astyle is set up to indent C/C++/C#/Java files, with four\n";
+    (*errorStream) << "spaces per indent, a maximal indentation of 40 spaces inside continuous\n";
+    (*errorStream) << "statements, a minimum indentation of eight spaces inside conditional\n";
+    (*errorStream) << "statements, and NO formatting options.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Option's Format:\n";
+    (*errorStream) << "----------------\n";
+    (*errorStream) << "    Long options (starting with '--') must be written one at a time.\n";
+    (*errorStream) << "    Short options (starting with '-') may be appended together.\n";
+    (*errorStream) << "    Thus, -bps4 is the same as -b -p -s4.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Default options file:\n";
+    (*errorStream) << "---------------------\n";
+    (*errorStream) << "    Artistic Style looks for a default options file in the\n";
+    (*errorStream) << "    following order:\n";
+    (*errorStream) << "    1. The contents of the ARTISTIC_STYLE_OPTIONS environment\n";
+    (*errorStream) << "       variable if it exists.\n";
+    (*errorStream) << "    2. The file called .astylerc in the directory pointed to by the\n";
+    (*errorStream) << "       HOME environment variable ( i.e. $HOME/.astylerc ).\n";
+    (*errorStream) << "    3. The file called astylerc in the directory pointed to by the\n";
+    (*errorStream) << "       USERPROFILE environment variable ( i.e. %USERPROFILE%\\astylerc ).\n";
+    (*errorStream) << "    If a default options file is found, the options in this file\n";
+    (*errorStream) << "    will be parsed BEFORE the command-line options.\n";
+    (*errorStream) << "    Long options within the default option file may be written without\n";
+    (*errorStream) << "    the preliminary '--'.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Bracket Style Options:\n";
+    (*errorStream) << "----------------------\n";
+    (*errorStream) << "    --style=allman  OR  --style=ansi  OR  --style=bsd\n";
+    (*errorStream) << "      OR  --style=break  OR  -A1\n";
+    (*errorStream) << "    Allman style formatting/indenting.\n";
+    (*errorStream) << "    Broken brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=java  OR  --style=attach  OR  -A2\n";
+    (*errorStream) << "    Java style formatting/indenting.\n";
+    (*errorStream) << "    Attached brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=kr  OR  --style=k&r  OR  --style=k/r  OR  -A3\n";
+    (*errorStream) << "    Kernighan & Ritchie style formatting/indenting.\n";
+    (*errorStream) << "    Linux brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=stroustrup  OR  -A4\n";
+    (*errorStream) << "    Stroustrup style formatting/indenting.\n";
+    (*errorStream) << "    Stroustrup brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=whitesmith  OR  -A5\n";
+    (*errorStream) << "    Whitesmith style formatting/indenting.\n";
+    (*errorStream) << "    Broken, indented brackets.\n";
+    (*errorStream) << "    Indented class blocks and switch blocks.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=banner  OR  -A6\n";
+    (*errorStream) << "    Banner style formatting/indenting.\n";
+    (*errorStream) << "    Attached, indented brackets.\n";
+    (*errorStream) << "    Indented class blocks and switch blocks.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=gnu  OR  -A7\n";
+    (*errorStream) << "    GNU style formatting/indenting.\n";
+    (*errorStream) << "    Broken brackets, indented blocks.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=linux  OR  -A8\n";
+    (*errorStream) << "    Linux style formatting/indenting.\n";
+    (*errorStream) << "    Linux brackets, minimum conditional indent is one-half indent.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=horstmann  OR  -A9\n";
+    (*errorStream) << "    Horstmann style formatting/indenting.\n";
+    (*errorStream) << "    Run-in brackets, indented switches.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=1tbs  OR  --style=otbs  OR  -A10\n";
+    (*errorStream) << "    One True Brace Style formatting/indenting.\n";
+    (*errorStream) << "    Linux brackets, add brackets to all conditionals.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=pico  OR  -A11\n";
+    (*errorStream) << "    Pico style formatting/indenting.\n";
+    (*errorStream) << "    Run-in opening brackets and attached closing brackets.\n";
+    (*errorStream) << "    Uses keep one line blocks and keep one line statements.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --style=lisp  OR  -A12\n";
+    (*errorStream) << "    Lisp style formatting/indenting.\n";
+    (*errorStream) << "    Attached opening brackets and attached closing brackets.\n";
+    (*errorStream) << "    Uses keep one line statements.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Tab Options:\n";
+    (*errorStream) << "------------\n";
+    (*errorStream) << "    default indent option\n";
+    (*errorStream) << "    If no indentation option is set,\n";
+    (*errorStream) << "    the default option of 4 spaces will be used.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent=spaces=#  OR  -s#\n";
+    (*errorStream) << "    Indent using # spaces per indent. Not specifying #\n";
+    (*errorStream) << "    will result in a default of 4 spaces per indent.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent=tab  OR  --indent=tab=#  OR  -t  OR  -t#\n";
+    (*errorStream) << "    Indent using tab characters, assuming that each\n";
+    (*errorStream) << "    tab is # spaces long. Not specifying # will result\n";
+    (*errorStream) << "    in a default assumption of 4 spaces per tab.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent=force-tab=#  OR  -T#\n";
+    (*errorStream) << "    Indent using tab characters, assuming that each\n";
+    (*errorStream) << "    tab is # spaces long. Force tabs to be used in areas\n";
+    (*errorStream) << "    Astyle would prefer to use spaces.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Old Bracket Options (deprectaied):\n";
+    (*errorStream) << "----------------------------------\n";
+    (*errorStream) << "The following bracket options have been depreciated and\n";
+    (*errorStream) << "will be removed in a future release.\n";
+    (*errorStream) << "Use the above Bracket Style Options instead.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=break  OR  -b  (deprectaied)\n";
+    (*errorStream) << "    Break brackets from pre-block code (i.e. ANSI C/C++ style).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=attach  OR  -a  (deprectaied)\n";
+    (*errorStream) << "    Attach brackets to pre-block code (i.e. Java/K&R style).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=linux  OR  -l  (deprectaied)\n";
+    (*errorStream) << "    Break definition-block brackets and attach command-block\n";
+    (*errorStream) << "    brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=stroustrup  OR  -u  (deprectaied)\n";
+    (*errorStream) << "    Attach all brackets except function definition brackets.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=run-in  OR  -g  (deprectaied)\n";
+    (*errorStream) << "    Break brackets from pre-block code, but allow following\n";
+    (*errorStream) << "    run-in statements on the same line as an opening bracket.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --brackets=horstmann\n";
+    (*errorStream) << "    THIS IS NO LONGER A VALID OPTION.\n";
+    (*errorStream) << "    Use style=horstmann instead.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Indentation options:\n";
+    (*errorStream) << "--------------------\n";
+    (*errorStream) << "    --indent-classes  OR  -C\n";
+    (*errorStream) << "    Indent 'class' blocks, so that the inner 'public:',\n";
+    (*errorStream) << "    'protected:' and 'private: headers are indented in\n";
+    (*errorStream) << "    relation to the class block.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-switches  OR  -S\n";
+    (*errorStream) << "    Indent 'switch' blocks, so that the inner 'case XXX:'\n";
+    (*errorStream) << "    headers are indented in relation to the switch block.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-cases  OR  -K\n";
+    (*errorStream) << "    Indent case blocks from the 'case XXX:' headers.\n";
+    (*errorStream) << "    Case statements not enclosed in blocks are NOT indented.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-brackets  OR  -B\n";
+    (*errorStream) << "    THIS IS NO LONGER A VALID OPTION.\n";
+    (*errorStream) << "    Use style=whitesmith or style=banner instead.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-blocks  OR  -G\n";
+    (*errorStream) << "    THIS IS NO LONGER A VALID OPTION.\n";
+    (*errorStream) << "    Use style=gnu instead.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-namespaces  OR  -N\n";
+    (*errorStream) << "    Indent the contents of namespace blocks.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-labels  OR  -L\n";
+    (*errorStream) << "    Indent labels so that they appear one indent less than\n";
+    (*errorStream) << "    the current indentation level, rather than being\n";
+    (*errorStream) << "    flushed completely to the left (which is the default).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-preprocessor  OR  -w\n";
+    (*errorStream) << "    Indent multi-line #define statements.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --indent-col1-comments  OR  -Y\n";
+    (*errorStream) << "    Indent line comments that start in column one.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --min-conditional-indent=#  OR  -m#\n";
+    (*errorStream) << "    Indent a minimal # spaces in a continuous conditional\n";
+    (*errorStream) << "    belonging to a conditional header.\n";
+    (*errorStream) << "    The valid values are:\n";
+    (*errorStream) << "    0 - no minimal indent.\n";
+    (*errorStream) << "    1 - indent at least one additional indent.\n";
+    (*errorStream) << "    2 - indent at least two additional indents.\n";
+    (*errorStream) << "    3 - indent at least one-half an additional indent.\n";
+    (*errorStream) << "    The default value is 2, two additional indents.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --max-instatement-indent=#  OR  -M#\n";
+    (*errorStream) << "    Indent a maximal # spaces in a continuous statement,\n";
+    (*errorStream) << "    relative to the previous line.\n";
+    (*errorStream) << "    The valid values are 40 thru 120.\n";
+    (*errorStream) << "    The default value is 40.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Padding options:\n";
+    (*errorStream) << "--------------------\n";
+    (*errorStream) << "    --break-blocks  OR  -f\n";
+    (*errorStream) << "    Insert empty lines around unrelated blocks, labels, classes, ...\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --break-blocks=all  OR  -F\n";
+    (*errorStream) << "    Like --break-blocks, except also insert empty lines \n";
+    (*errorStream) << "    around closing headers (e.g. 'else', 'catch', ...).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --pad-oper  OR  -p\n";
+    (*errorStream) << "    Insert space paddings around operators.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --pad-paren  OR  -P\n";
+    (*errorStream) << "    Insert space padding around parenthesis on both the outside\n";
+    (*errorStream) << "    and the inside.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --pad-paren-out  OR  -d\n";
+    (*errorStream) << "    Insert space padding around parenthesis on the outside only.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --pad-paren-in  OR  -D\n";
+    (*errorStream) << "    Insert space padding around parenthesis on the inside only.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --pad-header  OR  -H\n";
+    (*errorStream) << "    Insert space padding after paren headers (e.g. 'if', 'for'...).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --unpad-paren  OR  -U\n";
+    (*errorStream) << "    Remove unnecessary space padding around parenthesis.  This\n";
+    (*errorStream) << "    can be used in combination with the 'pad' options above.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --delete-empty-lines  OR  -xd\n";
+    (*errorStream) << "    Delete empty lines within a function or method.\n";
+    (*errorStream) << "    It will NOT delete lines added by the break-blocks options.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --fill-empty-lines  OR  -E\n";
+    (*errorStream) << "    Fill empty lines with the white space of their\n";
+    (*errorStream) << "    previous lines.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Formatting options:\n";
+    (*errorStream) << "-------------------\n";
+    (*errorStream) << "    --break-closing-brackets  OR  -y\n";
+    (*errorStream) << "    Break brackets before closing headers (e.g. 'else', 'catch', ...).\n";
+    (*errorStream) << "    Use with --brackets=attach, --brackets=linux, \n";
+    (*errorStream) << "    or --brackets=stroustrup.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --break-elseifs  OR  -e\n";
+    (*errorStream) << "    Break 'else if()' statements into two different lines.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --add-brackets  OR  -j\n";
+    (*errorStream) << "    Add brackets to unbracketed one line conditional statements.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --add-one-line-brackets  OR  -J\n";
+    (*errorStream) << "    Add one line brackets to unbracketed one line conditional\n";
+    (*errorStream) << "    statements.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --keep-one-line-blocks  OR  -O\n";
+    (*errorStream) << "    Don't break blocks residing completely on one line.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --keep-one-line-statements  OR  -o\n";
+    (*errorStream) << "    Don't break lines containing multiple statements into\n";
+    (*errorStream) << "    multiple single-statement lines.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --convert-tabs  OR  -c\n";
+    (*errorStream) << "    Convert tabs to the appropriate number of spaces.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --align-pointer=type    OR  -k1\n";
+    (*errorStream) << "    --align-pointer=middle  OR  -k2\n";
+    (*errorStream) << "    --align-pointer=name    OR  -k3\n";
+    (*errorStream) << "    Attach a pointer or reference operator (* or &) to either\n";
+    (*errorStream) << "    the operator type (left), middle, or operator name (right).\n";
+    (*errorStream) << "    To align the reference separately use --align-reference.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --align-reference=none    OR  -W0\n";
+    (*errorStream) << "    --align-reference=type    OR  -W1\n";
+    (*errorStream) << "    --align-reference=middle  OR  -W2\n";
+    (*errorStream) << "    --align-reference=name    OR  -W3\n";
+    (*errorStream) << "    Attach a reference operator (&) to either\n";
+    (*errorStream) << "    the operator type (left), middle, or operator name (right).\n";
+    (*errorStream) << "    If not set, follow pointer alignment.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --mode=c\n";
+    (*errorStream) << "    Indent a C or C++ source file (this is the default).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --mode=java\n";
+    (*errorStream) << "    Indent a Java source file.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --mode=cs\n";
+    (*errorStream) << "    Indent a C# source file.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Other options:\n";
+    (*errorStream) << "--------------\n";
+    (*errorStream) << "    --suffix=####\n";
+    (*errorStream) << "    Append the suffix #### instead of '.orig' to original filename.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --suffix=none  OR  -n\n";
+    (*errorStream) << "    Do not retain a backup of the original file.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --recursive  OR  -r  OR  -R\n";
+    (*errorStream) << "    Process subdirectories recursively.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --exclude=####\n";
+    (*errorStream) << "    Specify a file or directory #### to be excluded from processing.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    ignore-exclude-errors  OR  -i\n";
+    (*errorStream) << "    Allow processing to continue if there are errors in the exclude=###\n";
+    (*errorStream) << "    options. It will display the unmatched excludes.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    ignore-exclude-errors-x  OR  -xi\n";
+    (*errorStream) << "    Allow processing to continue if there are errors in the exclude=###\n";
+    (*errorStream) << "    options. It will NOT display the unmatched excludes.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --files-from=####\n";
+    (*errorStream) << "    Format the files listed in file ####, or standard input if #### is '-'.\n";
+    (*errorStream) << "    The file names are separated by NUL or newline characters.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --changed-since=####\n";
+    (*errorStream) << "    Format the files changed since the git revision ####. The file\n";
+    (*errorStream) << "    names on the command line select the files to check (e.g. \"*.cpp\").\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --watch\n";
+    (*errorStream) << "    After formatting, watch the files and format them again when they\n";
+    (*errorStream) << "    are saved. Available on Linux only.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --diff\n";
+    (*errorStream) << "    Display the changes as a unified diff on standard-output instead\n";
+    (*errorStream) << "    of changing the files. Implies --quiet.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --tar\n";
+    (*errorStream) << "    Read a tar archive from standard-input, format the members selected\n";
+    (*errorStream) << "    by the file names, and write the archive to standard-output.\n";
+    (*errorStream) << "    Implies --quiet.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --lsp\n";
+    (*errorStream) << "    Run a Language Server Protocol formatting server on standard-input\n";
+    (*errorStream) << "    and standard-output. The options are taken from the command line\n";
+    (*errorStream) << "    and the options file. Implies --quiet.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --errors-to-stdout  OR  -X\n";
+    (*errorStream) << "    Print errors and help information to standard-output rather than\n";
+    (*errorStream) << "    to standard-error.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --preserve-date  OR  -Z\n";
+    (*errorStream) << "    The date and time modified will not be changed in the formatted file.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --verbose  OR  -v\n";
+    (*errorStream) << "    Verbose mode. Extra informational messages will be displayed.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --formatted  OR  -Q\n";
+    (*errorStream) << "    Formatted display mode. Display only the files that have been formatted.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --quiet  OR  -q\n";
+    (*errorStream) << "    Quiet mode. Suppress all output except error messages.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --lineend=windows  OR  -z1\n";
+    (*errorStream) << "    --lineend=linux    OR  -z2\n";
+    (*errorStream) << "    --lineend=macold   OR  -z3\n";
+    (*errorStream) << "    Force use of the specified line end style. Valid options\n";
+    (*errorStream) << "    are windows (CRLF), linux (LF), and macold (CR).\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "Command Line Only:\n";
+    (*errorStream) << "------------------\n";
+    (*errorStream) << "    --options=####\n";
+    (*errorStream) << "    Specify an options file #### to read and use.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --options=none\n";
+    (*errorStream) << "    Disable the default options file.\n";
+    (*errorStream) << "    Only the command-line parameters will be used.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --ascii  OR  -I\n";
+    (*errorStream) << "    The displayed output will be ascii characters only.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --version  OR  -V\n";
+    (*errorStream) << "    Print version number.\n";
+    (*errorStream) << std::endl;
+    (*errorStream) << "    --help  OR  -h  OR  -?\n";
+    (*errorStream) << "    Print this help message.\n";
+    (*errorStream) << std::endl;
+  }
+
+
+  /**
+   * Process files in the fileNameVector and the file lists.
    */
   void ASConsole::processFiles()
   {
@@ -1982,15 +5075,73 @@ namespace astyle
 
     clock_t startTime = clock();     // start time of file formatting
 
-    // loop thru input fileNameVector and process the files
-    for(std::size_t i = 0; i < fileNameVector.size(); i++)
+    // with changed-since the fileNameVector contains git pathspecs
+    if(!changedSince.empty())
+    {
+      formatChangedFiles();
+    }
+    // with tar the fileNameVector selects the archive members
+    else if(isTar)
+    {
+      formatTarStream();
+    }
+    else
     {
-      getFilePaths(fileNameVector[i]);
+      // loop thru input fileNameVector and process the files
+      // consecutive entries without a wildcard are formatted together
+      std::vector<std::string> singleFiles;
+
+      for(std::size_t i = 0; i < fileNameVector.size(); i++)
+      {
+        getFilePaths(fileNameVector[i]);
+
+        if(!hasWildcard)
+        {
+          singleFiles.insert(singleFiles.end(), fileName.begin(), fileName.end());
+
+          // the gathered files are formatted before an entry that may display a message
+          if(i + 1 < fileNameVector.size() && isSingleFilePath(fileNameVector[i + 1]))
+          {
+            continue;
+          }
+
+          fileName.swap(singleFiles);
+          singleFiles.clear();
+        }
+
+        // loop thru fileName std::vector formatting the files
+        if(fileName.size() > 1)
+        {
+          formatFilesPipelined();
+        }
+        else
+        {
+          for(std::size_t j = 0; j < fileName.size(); j++)
+          {
+            formatFile(fileName[j]);
+          }
+        }
+      }
+    }
 
-      // loop thru fileName std::vector formatting the files
-      for(std::size_t j = 0; j < fileName.size(); j++)
+    // process the files-from list, "-" is standard input
+    if(!filesFrom.empty())
+    {
+      if(filesFrom == "-")
+      {
+        formatFileList(stdin);
+      }
+      else
       {
-        formatFile(fileName[j]);
+        FILE* fileList = fopen(filesFrom.c_str(), "rb");
+
+        if(fileList == nullptr)
+        {
+          error(_("Cannot open file list"), filesFrom.c_str());
+        }
+
+        formatFileList(fileList);
+        fclose(fileList);
       }
     }
 
@@ -1999,6 +5150,13 @@ namespace astyle
     {
       printVerboseStats(startTime);
     }
+
+    // continue formatting the files when they are changed
+    if(isWatch)
+    {
+      fflush(stdout);
+      watchFiles();
+    }
   }
 
 // process options from the command line and options file
@@ -2045,7 +5203,7 @@ namespace astyle
       else if(isOption(arg, "-V")
               || isOption(arg, "--version"))
       {
-        (*_err) << "Artistic Style Version " << g_version << std::endl;
+        (*errorStream) << "Artistic Style Version " << g_version << std::endl;
         exit(EXIT_SUCCESS);
       }
       else if(arg[0] == '-')
@@ -2099,7 +5257,7 @@ namespace astyle
     }
 
     // create the options file std::vector and parse the options for errors
-    ASOptions options(formatter);
+    ASOptions options(formatter, *this);
 
     if(optionsFileName.compare("") != 0)
     {
@@ -2126,8 +5284,8 @@ namespace astyle
 
     if(!ok)
     {
-      (*_err) << options.getOptionErrors() << std::endl;
-      (*_err) << _("For help on options type 'astyle -h'") << std::endl;
+      (*errorStream) << options.getOptionErrors() << std::endl;
+      (*errorStream) << _("For help on options type 'astyle -h'") << std::endl;
       error();
     }
 
@@ -2137,14 +5295,65 @@ namespace astyle
 
     if(!ok)
     {
-      (*_err) << options.getOptionErrors() << std::endl;
-      (*_err) << _("For help on options type 'astyle -h'") << std::endl;
+      (*errorStream) << options.getOptionErrors() << std::endl;
+      (*errorStream) << _("For help on options type 'astyle -h'") << std::endl;
       error();
     }
   }
 
+// create a hard link to a file
+// return false if the link cannot be created
+  bool ASConsole::linkFile(const char* oldFileName, const char* newFileName) const
+  {
+#if defined(_WIN32) || defined(__VMS)
+    (void) oldFileName;
+    (void) newFileName;
+    return false;
+#else
+
+    if(link(oldFileName, newFileName) != 0)
+    {
+      errno = 0;
+      return false;
+    }
+
+    return true;
+#endif
+  }
+
+// quote an argument for a command run by the shell
+  std::string ASConsole::quoteCommandArg(const std::string& arg) const
+  {
+#ifdef _WIN32
+    if(arg.find('"') != std::string::npos)
+    {
+      error(_("Cannot quote command argument"), arg.c_str());
+    }
+
+    return '"' + arg + '"';
+#else
+    std::string quoted = "'";
+
+    for(std::size_t i = 0; i < arg.length(); i++)
+    {
+      if(arg[i] == '\'')
+      {
+        quoted.append("'\\''");
+      }
+      else
+      {
+        quoted.append(1, arg[i]);
+      }
+    }
+
+    quoted.append("'");
+    return quoted;
+#endif
+  }
+
 // remove a file and check for an error
-  void ASConsole::removeFile(const char* fileName_, const char* errMsg) const
+// an error is recorded in the buffer
+  bool ASConsole::removeFile(ASFileBuffer& buffer, const char* fileName_, const char* errMsg) const
   {
     remove(fileName_);
 
@@ -2156,12 +5365,17 @@ namespace astyle
     if(errno)
     {
       perror("errno message");
-      error(errMsg, fileName_);
+      fileError(buffer, errMsg, fileName_);
+      return false;
     }
+
+    return true;
   }
 
 // rename a file and check for an error
-  void ASConsole::renameFile(const char* oldFileName, const char* newFileName, const char* errMsg) const
+// an error is recorded in the buffer
+  bool ASConsole::renameFile(ASFileBuffer& buffer, const char* oldFileName, const char* newFileName,
+                             const char* errMsg) const
   {
     rename(oldFileName, newFileName);
 
@@ -2176,8 +5390,11 @@ namespace astyle
     if(errno)
     {
       perror("errno message");
-      error(errMsg, oldFileName);
+      fileError(buffer, errMsg, oldFileName);
+      return false;
     }
+
+    return true;
   }
 
 // make sure file separators are correct type (Windows or Linux)
@@ -2325,6 +5542,12 @@ namespace astyle
     std::string unchanged = getNumberFormat(filesUnchanged);
     printf(_(" %s formatted   %s unchanged   "), formatted.c_str(), unchanged.c_str());
 
+    if(filesNotVerified > 0)
+    {
+      std::string notVerified = getNumberFormat(filesNotVerified);
+      printf(_("%s not verified   "), notVerified.c_str());
+    }
+
     // show processing time
     clock_t stopTime = clock();
     float secs = (stopTime - startTime) / float(CLOCKS_PER_SEC);
@@ -2357,14 +5580,30 @@ namespace astyle
 
     std::string lines = getNumberFormat(linesOut);
     printf(_("%s lines\n"), lines.c_str());
+
+    // show the average buffers waiting in the pipeline queues
+    if(pipelineFiles > 0)
+    {
+      printf(_(" queue occupancy   read %.1f   write %.1f\n"),
+             float(readOccupancy) / pipelineFiles, float(writeOccupancy) / pipelineFiles);
+    }
   }
 
-  void ASConsole::sleep(std::int32_t seconds) const
+// suspend the thread without using the processor
+  void ASConsole::sleep(std::int32_t milliseconds) const
   {
-    clock_t endwait;
-    endwait = clock_t (clock() + seconds * CLOCKS_PER_SEC);
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    struct timespec request;
+    request.tv_sec = milliseconds / 1000;
+    request.tv_nsec = (milliseconds % 1000) * 1000000L;
 
-    while(clock() < endwait) {}
+    // continue the sleep if it is interrupted by a signal
+    while(nanosleep(&request, &request) == -1 && errno == EINTR) {}
+
+    errno = 0;
+#endif
   }
 
   bool ASConsole::stringEndsWith(const std::string& str, const std::string& suffix) const
@@ -2425,7 +5664,7 @@ namespace astyle
 
     std::size_t len = 0;
     std::size_t wcharLen = tlen / 2;
-    const short* uptr = reinterpret_cast<const short*>(data);
+    const unsigned short* uptr = reinterpret_cast<const unsigned short*>(data);
 
     for(std::size_t i = 0; i < wcharLen && uptr[i];)
     {
@@ -2716,12 +5955,12 @@ namespace astyle
   std::int32_t ASConsole::waitForRemove(const char* newFileName) const
   {
     struct stat stBuf;
-    std::int32_t seconds;
+    std::int32_t waits;
 
-    // sleep a max of 20 seconds for the remove
-    for(seconds = 1; seconds <= 20; seconds++)
+    // wait a max of 20 seconds for the remove, checking every 100 milliseconds
+    for(waits = 1; waits <= 200; waits++)
     {
-      sleep(1);
+      sleep(100);
 
       if(stat(newFileName, &stBuf) != 0)
       {
@@ -2730,7 +5969,7 @@ namespace astyle
     }
 
     errno = 0;
-    return seconds;
+    return (waits + 9) / 10;
   }
 
 // From The Code Project http://www.codeproject.com/std::string/wildcmp.asp
@@ -2805,8 +6044,10 @@ namespace astyle
     return !*wild;
   }
 
-  void ASConsole::writeFile(const std::string& fileName_, FileEncoding encoding, std::ostringstream& out) const
+  void ASConsole::writeFile(ASFileBuffer& buffer) const
   {
+    const std::string& fileName_ = buffer.fileName;
+
     // save date accessed and date modified of original file
     struct stat stBuf;
     bool statErr = false;
@@ -2816,41 +6057,193 @@ namespace astyle
       statErr = true;
     }
 
+    // Write to a temporary file that atomically replaces the original file.
+    // The original file is never partially written and there is no need
+    // to wait for a remove.
+    std::string tempFileName = createTempFile(fileName_);
+    std::string outFileName = tempFileName.empty() ? fileName_ : tempFileName;
+
     // create a backup
+    // with a temporary file the backup is a hard link to the original file
     if(!noBackup)
     {
       std::string origFileName = fileName_ + origSuffix;
-      removeFile(origFileName.c_str(), "Cannot remove pre-existing backup file");
-      renameFile(fileName_.c_str(), origFileName.c_str(), "Cannot create backup file");
+      bool isBackedUp = removeFile(buffer, origFileName.c_str(), "Cannot remove pre-existing backup file");
+
+      if(isBackedUp && (tempFileName.empty() || !linkFile(fileName_.c_str(), origFileName.c_str())))
+      {
+        isBackedUp = renameFile(buffer, fileName_.c_str(), origFileName.c_str(), "Cannot create backup file");
+      }
+
+      if(!isBackedUp)
+      {
+        if(!tempFileName.empty())
+        {
+          remove(tempFileName.c_str());
+        }
+
+        return;
+      }
     }
 
     // write the output file
-    std::ofstream fout(fileName_.c_str(), std::ios::binary | std::ios::trunc);
+    std::ofstream fout(outFileName.c_str(), std::ios::binary | std::ios::trunc);
 
     if(!fout)
     {
-      error("Cannot open output file", fileName_.c_str());
+      if(!tempFileName.empty())
+      {
+        remove(tempFileName.c_str());
+      }
+
+      fileError(buffer, "Cannot open output file", outFileName.c_str());
+      return;
     }
 
-    if(encoding == UTF_16LE || encoding == UTF_16BE)
+    fout << getOutputData(buffer.encoding, buffer.out.str());
+    fout.close();
+
+    if(!fout)
     {
-      // convert utf-8 to utf-16
-      std::size_t utf16Size = Utf16Length(out.str().c_str(), out.str().length());
-      char* utf16Out = new char[utf16Size];
-      std::size_t utf16Len = Utf8ToUtf16(const_cast<char*>(out.str().c_str()), out.str().length(), encoding, utf16Out);
-      assert(utf16Len == utf16Size);
-      fout << std::string(utf16Out, utf16Len);
-      delete []utf16Out;
+      if(!tempFileName.empty())
+      {
+        remove(tempFileName.c_str());
+      }
+
+      fileError(buffer, "Cannot write output file", outFileName.c_str());
+      return;
     }
-    else
+
+    // replace the original file
+    if(!tempFileName.empty())
+    {
+      errno = 0;
+
+      if(!renameFile(buffer, tempFileName.c_str(), fileName_.c_str(), "Cannot replace output file"))
+      {
+        remove(tempFileName.c_str());
+        return;
+      }
+    }
+
+    // change date modified to original file date
+    // Embarcadero must be linked with cw32mt not cw32
+    if(preserveDate)
+    {
+      if(!statErr)
+      {
+        struct utimbuf outBuf;
+        outBuf.actime = stBuf.st_atime;
+        // add ticks so 'make' will recoginze a change
+        // Visual Studio 2008 needs more than 1
+        outBuf.modtime = stBuf.st_mtime + 10;
+
+        if(utime(fileName_.c_str(), &outBuf) == -1)
+        {
+          statErr = true;
+        }
+      }
+
+      if(statErr)
+      {
+        perror("errno message");
+        (*errorStream) << "*********  Cannot preserve file date" << std::endl;
+      }
+    }
+  }
+
+  /**
+   * Replace a streamed file with the temporary file of the formatted text.
+   * The temporary file is renamed if possible, otherwise it is copied into
+   * the file so the links to the file are not broken.
+   *
+   * @param buffer        The buffer for the streamed file.
+   */
+  void ASConsole::writeStreamedFile(ASFileBuffer& buffer) const
+  {
+    const std::string& fileName_ = buffer.fileName;
+    const std::string& tempFileName = buffer.tempFileName;
+
+    // save date accessed and date modified of original file
+    struct stat stBuf;
+    bool statErr = false;
+
+    if(stat(fileName_.c_str(), &stBuf) == -1)
+    {
+      statErr = true;
+    }
+
+    // create a backup
+    // with a renamed temporary file the backup is a hard link to the original file
+    if(!noBackup)
+    {
+      std::string origFileName = fileName_ + origSuffix;
+      bool isBackedUp = removeFile(buffer, origFileName.c_str(), "Cannot remove pre-existing backup file");
+
+      if(isBackedUp && (!buffer.isTempFileRenamed || !linkFile(fileName_.c_str(), origFileName.c_str())))
+      {
+        isBackedUp = renameFile(buffer, fileName_.c_str(), origFileName.c_str(), "Cannot create backup file");
+      }
+
+      if(!isBackedUp)
+      {
+        remove(tempFileName.c_str());
+        return;
+      }
+    }
+
+    if(buffer.isTempFileRenamed)
     {
-      fout << out.str();
+      errno = 0;
+
+      if(!renameFile(buffer, tempFileName.c_str(), fileName_.c_str(), "Cannot replace output file"))
+      {
+        remove(tempFileName.c_str());
+        return;
+      }
     }
+    else
+    {
+      // copy the temporary file into the output file
+      const std::int32_t blockSize = 131072;  // 128 KB
+      std::ifstream fin(tempFileName.c_str(), std::ios::binary);
+      std::ofstream fout(fileName_.c_str(), std::ios::binary | std::ios::trunc);
+
+      if(!fin || !fout)
+      {
+        fin.close();
+        remove(tempFileName.c_str());
+        fileError(buffer, "Cannot open output file", fileName_.c_str());
+        return;
+      }
+
+      std::vector<char> data(blockSize);
+
+      while(fin.read(&data[0], blockSize) || fin.gcount() > 0)
+      {
+        fout.write(&data[0], fin.gcount());
+      }
 
-    fout.close();
+      fout.close();
+
+      // the file has been partly written, the temporary file is kept
+      // because it may be the only complete copy of the formatted text
+      if(!fout || fin.bad())
+      {
+        fileError(buffer, "Cannot write output file", fileName_.c_str());
+        return;
+      }
+
+      fin.close();
+      errno = 0;
+
+      if(!removeFile(buffer, tempFileName.c_str(), "Cannot remove temporary file"))
+      {
+        return;
+      }
+    }
 
     // change date modified to original file date
-    // Embarcadero must be linked with cw32mt not cw32
     if(preserveDate)
     {
       if(!statErr)
@@ -2858,7 +6251,6 @@ namespace astyle
         struct utimbuf outBuf;
         outBuf.actime = stBuf.st_atime;
         // add ticks so 'make' will recoginze a change
-        // Visual Studio 2008 needs more than 1
         outBuf.modtime = stBuf.st_mtime + 10;
 
         if(utime(fileName_.c_str(), &outBuf) == -1)
@@ -2870,7 +6262,7 @@ namespace astyle
       if(statErr)
       {
         perror("errno message");
-        (*_err) << "*********  Cannot preserve file date" << std::endl;
+        (*errorStream) << "*********  Cannot preserve file date" << std::endl;
       }
     }
   }
@@ -3407,7 +6799,7 @@ namespace astyle
     // Options used by only console ///////////////////////////////////////////////////////////////
     else if(isOption(arg, "n", "suffix=none"))
     {
-      g_console->setNoBackup(true);
+      console.setNoBackup(true);
     }
     else if(isParamOption(arg, "suffix="))
     {
@@ -3415,7 +6807,7 @@ namespace astyle
 
       if(suffixParam.length() > 0)
       {
-        g_console->setOrigSuffix(suffixParam);
+        console.setOrigSuffix(suffixParam);
       }
     }
     else if(isParamOption(arg, "exclude="))
@@ -3424,40 +6816,85 @@ namespace astyle
 
       if(suffixParam.length() > 0)
       {
-        g_console->updateExcludeVector(suffixParam);
+        console.updateExcludeVector(suffixParam);
       }
     }
     else if(isOption(arg, "r", "R") || isOption(arg, "recursive"))
     {
-      g_console->setIsRecursive(true);
+      console.setIsRecursive(true);
     }
     else if(isOption(arg, "Z", "preserve-date"))
     {
-      g_console->setPreserveDate(true);
+      console.setPreserveDate(true);
     }
     else if(isOption(arg, "v", "verbose"))
     {
-      g_console->setIsVerbose(true);
+      console.setIsVerbose(true);
+    }
+    else if(isOption(arg, "watch"))
+    {
+      console.setIsWatch(true);
+    }
+    else if(isOption(arg, "diff"))
+    {
+      console.setIsDiff(true);
+      console.setIsQuiet(true);
+    }
+    else if(isOption(arg, "tar"))
+    {
+      console.setIsTar(true);
+      console.setIsQuiet(true);
+    }
+    else if(isOption(arg, "lsp"))
+    {
+      console.setIsLsp(true);
+      console.setIsQuiet(true);
     }
     else if(isOption(arg, "Q", "formatted"))
     {
-      g_console->setIsFormattedOnly(true);
+      console.setIsFormattedOnly(true);
     }
     else if(isOption(arg, "q", "quiet"))
     {
-      g_console->setIsQuiet(true);
+      console.setIsQuiet(true);
     }
     else if(isOption(arg, "i", "ignore-exclude-errors"))
     {
-      g_console->setIgnoreExcludeErrors(true);
+      console.setIgnoreExcludeErrors(true);
     }
     else if(isOption(arg, "xi", "ignore-exclude-errors-x"))
     {
-      g_console->setIgnoreExcludeErrorsAndDisplay(true);
+      console.setIgnoreExcludeErrorsAndDisplay(true);
     }
     else if(isOption(arg, "X", "errors-to-stdout"))
     {
-      _err = &std::cout;
+      console.setErrorStream(&std::cout);
+    }
+    else if(isParamOption(arg, "files-from="))
+    {
+      std::string listParam = getParam(arg, "files-from=");
+
+      if(listParam.length() > 0)
+      {
+        console.setFilesFrom(listParam);
+      }
+      else
+      {
+        isOptionError(arg, errorInfo);
+      }
+    }
+    else if(isParamOption(arg, "changed-since="))
+    {
+      std::string revisionParam = getParam(arg, "changed-since=");
+
+      if(revisionParam.length() > 0)
+      {
+        console.setChangedSince(revisionParam);
+      }
+      else
+      {
+        isOptionError(arg, errorInfo);
+      }
     }
     else if(isOption(arg, "lineend=windows"))
     {
@@ -3613,6 +7050,150 @@ namespace astyle
 
 // *******************   end of ASOptions functions   *********************************************
 
+#ifdef ASTYLE_LIB
+//-----------------------------------------------------------------------------
+// ASMemoryStreamBuf class
+// used by library build only
+//-----------------------------------------------------------------------------
+
+  ASMemoryStreamBuf::ASMemoryStreamBuf(const char* data, std::size_t dataSize)
+  {
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + dataSize);
+  }
+
+// set the read position relative to the beginning, current position, or end
+  std::streambuf::pos_type ASMemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                      std::ios_base::openmode which)
+  {
+    off_type newPos = off;
+
+    if(dir == std::ios_base::cur)
+    {
+      newPos += gptr() - eback();
+    }
+    else if(dir == std::ios_base::end)
+    {
+      newPos += egptr() - eback();
+    }
+
+    if(!(which & std::ios_base::in) || newPos < 0 || newPos > egptr() - eback())
+    {
+      return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + newPos, egptr());
+    return pos_type(newPos);
+  }
+
+  std::streambuf::pos_type ASMemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+  {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+
+//-----------------------------------------------------------------------------
+// ASLibFormatter class
+// used by library build only
+//-----------------------------------------------------------------------------
+
+  /**
+   * Format a source text with the options of the formatter.
+   * The text is read in place and the formatted text replaces the previous one.
+   *
+   * @param textIn            The source text to be formatted, it need not be NUL terminated.
+   * @param textSizeIn        The size of the source text.
+   * @param fpErrorHandler    The error handler function.
+   * @return                  true if the formatted text is available from getTextOut().
+   */
+  bool ASLibFormatter::formatText(const char* textIn, std::size_t textSizeIn, fpError fpErrorHandler)
+  {
+    ASMemoryStreamBuf inBuffer(textIn, textSizeIn);
+    std::istream in(&inBuffer);
+    ASStreamIterator<std::istream> streamIterator(&in);
+    textOut.clear();                 // the formatted lines are appended to this
+    textOut.reserve(textSizeIn + textSizeIn / 8);
+    formatter.init(&streamIterator);
+
+    while(formatter.hasMoreLines())
+    {
+      formatter.nextLine(textOut);
+
+      if(formatter.hasMoreLines())
+      {
+        textOut.append(streamIterator.getOutputEOL());
+      }
+      else
+      {
+        // this can happen if the file if missing a closing bracket and break-blocks is requested
+        if(formatter.getIsLineReady())
+        {
+          textOut.append(streamIterator.getOutputEOL());
+          formatter.nextLine(textOut);
+        }
+      }
+    }
+
+    // do NOT return output that does not match the input
+    if(formatter.getChecksumDiff() != 0)
+    {
+      textOut.clear();
+      fpErrorHandler(120, "Formatted output does not match the input.");
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Get the edits that change a source text into the formatted text.
+   * Call after formatText() with the same source text.
+   * The edits are written as the compact edit list of ASLineDiff.
+   *
+   * @param textIn            The source text that was formatted.
+   * @param textSizeIn        The size of the source text.
+   * @param editsOut          Receives the edit list, empty if formatting made no changes.
+   */
+  void ASLibFormatter::getTextEdits(const char* textIn, std::size_t textSizeIn, std::string& editsOut) const
+  {
+    ASLineDiff lineDiff(std::string_view(textIn, textSizeIn), textOut);
+    editsOut.clear();
+    lineDiff.writeEditList(editsOut);
+  }
+
+  const std::string& ASLibFormatter::getTextOut() const
+  {
+    return textOut;
+  }
+
+  /**
+   * Parse the options and set them in the formatter.
+   * An option error is reported to the error handler and the valid options are set.
+   *
+   * @param pOptions          The AStyle options, separated by \n.
+   * @param fpErrorHandler    The error handler function.
+   * @return                  true if there were no option errors.
+   */
+  bool ASLibFormatter::setOptions(const char* pOptions, fpError fpErrorHandler)
+  {
+    ASOptions options(formatter);
+    std::vector<std::string> optionsVector;
+    std::istringstream opt(pOptions);
+
+    options.importOptions(opt, optionsVector);
+
+    bool ok = options.parseOptions(optionsVector,
+                                   "Invalid Artistic Style options:");
+
+    if(!ok)
+    {
+      fpErrorHandler(210, options.getOptionErrors().c_str());
+    }
+
+    return ok;
+  }
+
+#endif  // ASTYLE_LIB
+
 }   // end of namespace astyle
 
 // *******************   end of astyle namespace    ***********************************************
@@ -3637,18 +7218,10 @@ jstring STDCALL Java_AStyleInterface_AStyleMain(JNIEnv* env,
     jstring textInJava,
     jstring optionsJava)
 {
-  g_env = env;                                // make object available globally
-  g_obj = obj;                                // make object available globally
-
   jstring textErr = env->NewStringUTF("");    // zero length text returned if an error occurs
 
-  // get the method ID
-  jclass cls = env->GetObjectClass(obj);
-  g_mid = env->GetMethodID(cls, "ErrorHandler", "(ILjava/lang/String;)V");
-
-  if(g_mid == 0)
+  if(!setJavaErrorHandler(env, obj))
   {
-    cout << "Cannot find java method ErrorHandler" << std::endl;
     return textErr;
   }
 
@@ -3674,6 +7247,156 @@ jstring STDCALL Java_AStyleInterface_AStyleMain(JNIEnv* env,
   return textOutJava;
 }
 
+// called by a java program to create a formatter with the options
+// the formatter handle is kept by the java program and used to format many sources
+// a zero handle is returned if there are option errors
+extern "C"  EXPORT
+jlong STDCALL Java_AStyleInterface_AStyleCreateFormatter(JNIEnv* env,
+    jobject obj,
+    jstring optionsJava)
+{
+  if(!setJavaErrorHandler(env, obj))
+  {
+    return 0;
+  }
+
+  const char* options = env->GetStringUTFChars(optionsJava, nullptr);
+  ASLibFormatter* formatter = new ASLibFormatter;
+  bool ok = formatter->setOptions(options, javaErrorHandler);
+  env->ReleaseStringUTFChars(optionsJava, options);
+
+  if(!ok)
+  {
+    delete formatter;
+    return 0;
+  }
+
+  return reinterpret_cast<jlong>(formatter);
+}
+
+// called by a java program to delete a formatter created by AStyleCreateFormatter
+extern "C"  EXPORT
+void STDCALL Java_AStyleInterface_AStyleDeleteFormatter(JNIEnv*,
+    jobject,
+    jlong formatterHandle)
+{
+  delete reinterpret_cast<ASLibFormatter*>(formatterHandle);
+}
+
+// called by a java program to format the UTF-8 source in a direct ByteBuffer
+// the source is read in place and the formatted text is copied to the output direct ByteBuffer
+// the formatted length is returned, or -1 if an error occurs
+// if the length is greater than the output capacity the text is not copied,
+// and it may be copied to a larger buffer with AStyleGetFormattedText
+extern "C"  EXPORT
+jint STDCALL Java_AStyleInterface_AStyleFormatBuffer(JNIEnv* env,
+    jobject obj,
+    jlong formatterHandle,
+    jobject textInBuffer,
+    jint textInLength,
+    jobject textOutBuffer)
+{
+  if(!setJavaErrorHandler(env, obj))
+  {
+    return -1;
+  }
+
+  ASLibFormatter* formatter = reinterpret_cast<ASLibFormatter*>(formatterHandle);
+
+  if(formatter == nullptr)
+  {
+    javaErrorHandler(104, "No formatter handle.");
+    return -1;
+  }
+
+  const char* textIn = static_cast<const char*>(env->GetDirectBufferAddress(textInBuffer));
+
+  if(textIn == nullptr || textInLength < 0 || textInLength > env->GetDirectBufferCapacity(textInBuffer))
+  {
+    javaErrorHandler(101, "No pointer to source input.");
+    return -1;
+  }
+
+  if(!formatter->formatText(textIn, static_cast<std::size_t>(textInLength), javaErrorHandler))
+  {
+    return -1;
+  }
+
+  return copyJavaTextOut(env, formatter, textOutBuffer);
+}
+
+// called by a java program to copy the last formatted text to a direct ByteBuffer
+// used when the output buffer given to AStyleFormatBuffer was too small
+extern "C"  EXPORT
+jint STDCALL Java_AStyleInterface_AStyleGetFormattedText(JNIEnv* env,
+    jobject obj,
+    jlong formatterHandle,
+    jobject textOutBuffer)
+{
+  if(!setJavaErrorHandler(env, obj))
+  {
+    return -1;
+  }
+
+  ASLibFormatter* formatter = reinterpret_cast<ASLibFormatter*>(formatterHandle);
+
+  if(formatter == nullptr)
+  {
+    javaErrorHandler(104, "No formatter handle.");
+    return -1;
+  }
+
+  return copyJavaTextOut(env, formatter, textOutBuffer);
+}
+
+// Copy the formatted text to a direct ByteBuffer if it fits, and return the length
+jint copyJavaTextOut(JNIEnv* env, const ASLibFormatter* formatter, jobject textOutBuffer)
+{
+  char* textOut = static_cast<char*>(env->GetDirectBufferAddress(textOutBuffer));
+  jlong textOutCapacity = env->GetDirectBufferCapacity(textOutBuffer);
+
+  if(textOut == nullptr || textOutCapacity < 0)
+  {
+    javaErrorHandler(105, "No pointer to output buffer.");
+    return -1;
+  }
+
+  const std::string& text = formatter->getTextOut();
+
+  if(text.length() > static_cast<std::size_t>(INT32_MAX))
+  {
+    javaErrorHandler(110, "Allocation failure on output.");
+    return -1;
+  }
+
+  if(static_cast<jlong>(text.length()) <= textOutCapacity)
+  {
+    memcpy(textOut, text.data(), text.length());
+  }
+
+  return static_cast<jint>(text.length());
+}
+
+// Set the Java error handler for the calling thread
+// the object and method are used by javaErrorHandler
+bool setJavaErrorHandler(JNIEnv* env, jobject obj)
+{
+  g_env = env;                                // make object available globally
+  g_obj = obj;                                // make object available globally
+
+  // get the method ID
+  jclass cls = env->GetObjectClass(obj);
+  g_mid = env->GetMethodID(cls, "ErrorHandler", "(ILjava/lang/String;)V");
+
+  if(g_mid == 0)
+  {
+    std::cout << "Cannot find java method ErrorHandler" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 // Call the Java error handler
 void STDCALL javaErrorHandler(std::int32_t errorNumber, const char* errorMessage)
 {
@@ -3685,23 +7408,20 @@ void STDCALL javaErrorHandler(std::int32_t errorNumber, const char* errorMessage
 char* STDCALL javaMemoryAlloc(unsigned long memoryNeeded)
 {
   // error condition is checked after return from AStyleMain
-  char* buffer = new(nothrow) char [memoryNeeded];
+  char* buffer = new(std::nothrow) char [memoryNeeded];
   return buffer;
 }
 #endif
 
 #ifdef ASTYLE_LIB
 // *************************   GUI functions   ****************************************************
-/*
- * IMPORTANT VC DLL linker for WIN32 must have the parameter  /EXPORT:AStyleMain=_AStyleMain@16
- *                                                            /EXPORT:AStyleGetVersion=_AStyleGetVersion@0
- * No /EXPORT is required for x64
- */
-extern "C" EXPORT char* STDCALL
-AStyleMain(const char* pSourceIn,          // pointer to the source to be formatted
-           const char* pOptions,           // pointer to AStyle options, separated by \n
-           fpError fpErrorHandler,         // pointer to error handler function
-           fpAlloc fpMemoryAlloc)          // pointer to memory allocation function
+// format the source for AStyleMain and AStyleMainEdits
+// the output is the formatted text, or the edit list if returnEdits is set
+static char* formatSource(const char* pSourceIn,
+                          const char* pOptions,
+                          fpError fpErrorHandler,
+                          fpAlloc fpMemoryAlloc,
+                          bool returnEdits)
 {
   if(fpErrorHandler == nullptr)          // cannot display a message if no error handler
   {
@@ -3726,47 +7446,33 @@ AStyleMain(const char* pSourceIn,          // pointer to the source to be format
     return nullptr;
   }
 
-  ASFormatter formatter;
-  ASOptions options(formatter);
-
-  std::vector<std::string> optionsVector;
-  istringstream opt(pOptions);
+  // option errors are reported and the valid options are used
+  ASLibFormatter formatter;
+  formatter.setOptions(pOptions, fpErrorHandler);
+  std::size_t textSizeIn = strlen(pSourceIn);
 
-  options.importOptions(opt, optionsVector);
-
-  bool ok = options.parseOptions(optionsVector,
-                                 "Invalid Artistic Style options:");
-
-  if(!ok)
+  if(!formatter.formatText(pSourceIn, textSizeIn, fpErrorHandler))
   {
-    fpErrorHandler(210, options.getOptionErrors().c_str());
+    return nullptr;
   }
 
-  istringstream in(pSourceIn);
-  ASStreamIterator<istringstream> streamIterator(&in);
-  ostringstream out;
-  formatter.init(&streamIterator);
+  std::string edits;
+  const std::string* out = &formatter.getTextOut();
 
-  while(formatter.hasMoreLines())
+  if(returnEdits)
   {
-    out << formatter.nextLine();
+    formatter.getTextEdits(pSourceIn, textSizeIn, edits);
+    out = &edits;
+  }
 
-    if(formatter.hasMoreLines())
-    {
-      out << streamIterator.getOutputEOL();
-    }
-    else
-    {
-      // this can happen if the file if missing a closing bracket and break-blocks is requested
-      if(formatter.getIsLineReady())
-      {
-        out << streamIterator.getOutputEOL();
-        out << formatter.nextLine();
-      }
-    }
+  // the allocation callback takes an unsigned long, which is 32 bits on Windows
+  if(out->length() >= std::numeric_limits<unsigned long>::max())
+  {
+    fpErrorHandler(110, "Allocation failure on output.");
+    return nullptr;
   }
 
-  unsigned long textSizeOut = out.str().length();
+  unsigned long textSizeOut = static_cast<unsigned long>(out->length());
   char* pTextOut = fpMemoryAlloc(textSizeOut + 1);     // call memory allocation function
 
 //    pTextOut = nullptr;           // for testing
@@ -3776,11 +7482,41 @@ AStyleMain(const char* pSourceIn,          // pointer to the source to be format
     return nullptr;
   }
 
-  strcpy(pTextOut, out.str().c_str());
-  assert(formatter.getChecksumDiff() == 0);
+  strcpy(pTextOut, out->c_str());
   return pTextOut;
 }
 
+/*
+ * IMPORTANT VC DLL linker for WIN32 must have the parameter  /EXPORT:AStyleMain=_AStyleMain@16
+ *                                                            /EXPORT:AStyleMainEdits=_AStyleMainEdits@16
+ *                                                            /EXPORT:AStyleGetVersion=_AStyleGetVersion@0
+ * No /EXPORT is required for x64
+ */
+extern "C" EXPORT char* STDCALL
+AStyleMain(const char* pSourceIn,          // pointer to the source to be formatted
+           const char* pOptions,           // pointer to AStyle options, separated by \n
+           fpError fpErrorHandler,         // pointer to error handler function
+           fpAlloc fpMemoryAlloc)          // pointer to memory allocation function
+{
+  return formatSource(pSourceIn, pOptions, fpErrorHandler, fpMemoryAlloc, false);
+}
+
+/*
+ * Format the source and return only the changes, as an edit list instead of the formatted text.
+ * Each edit is a line "origLine deleteCount insertCount insertSize" followed by the
+ * insertSize bytes of the inserted lines. Lines are numbered from zero in the source
+ * and end with LF, a CR is part of the line as in diff and patch.
+ * The edits are in line order and an empty string means the source is unchanged.
+ */
+extern "C" EXPORT char* STDCALL
+AStyleMainEdits(const char* pSourceIn,     // pointer to the source to be formatted
+                const char* pOptions,      // pointer to AStyle options, separated by \n
+                fpError fpErrorHandler,    // pointer to error handler function
+                fpAlloc fpMemoryAlloc)     // pointer to memory allocation function
+{
+  return formatSource(pSourceIn, pOptions, fpErrorHandler, fpMemoryAlloc, true);
+}
+
 extern "C" EXPORT const char* STDCALL AStyleGetVersion(void)
 {
   return g_version;
@@ -3795,25 +7531,37 @@ std::int32_t main(std::int32_t argc, char** argv)
 {
   // create objects
   ASFormatter formatter;
-  g_console = new ASConsole(formatter);
+  ASConsole console(formatter);
+  console.setOutputBuffering();
 
   // process command line and options file
   // build the vectors fileNameVector, optionsVector, and fileOptionsVector
   std::vector<std::string> argvOptions;
-  argvOptions = g_console->getArgvOptions(argc, argv);
-  g_console->processOptions(argvOptions);
+  argvOptions = console.getArgvOptions(argc, argv);
+  console.processOptions(argvOptions);
+
+  // with the lsp option, serve formatting requests on cin and cout
+  if(console.getIsLsp())
+  {
+    return console.runLanguageServer() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
 
   // if no files have been given, use cin for input and cout for output
-  if(g_console->fileNameVectorIsEmpty())
+  if(console.fileNameVectorIsEmpty() && console.fileListIsEmpty())
   {
-    g_console->formatCinToCout();
+    console.formatCinToCout();
     return EXIT_SUCCESS;
   }
 
   // process entries in the fileNameVector
-  g_console->processFiles();
+  console.processFiles();
+
+  // a file that was not changed because the output did not match is a failure
+  if(console.getFilesNotVerified() > 0)
+  {
+    return EXIT_FAILURE;
+  }
 
-  delete g_console;
   return EXIT_SUCCESS;
 }
 
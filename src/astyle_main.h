@@ -32,10 +32,21 @@
 // headers
 //----------------------------------------------------------------------------
 
+#include <iostream>
 #include <sstream>
+#include <string_view>
 #include <ctime>
 #include "astyle.h"
 
+// for console build only
+#ifndef ASTYLE_LIB
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
 #if defined(_MSC_VER) || defined(__DMC__)
 #include <sys/utime.h>
 #include <sys/stat.h>
@@ -102,12 +113,13 @@ namespace astyle
   private:
     ASStreamIterator(const ASStreamIterator& copy);       // copy constructor not to be imlpemented
     ASStreamIterator& operator=(ASStreamIterator&);       // assignment operator not to be implemented
+    std::int32_t readRecord(std::string& record);
     T* inStream;           // pointer to the input stream
     std::string buffer;         // current input line
     std::string prevBuffer;     // previous input line
-    std::int32_t eolWindows;        // number of Windows line endings, CRLF
-    std::int32_t eolLinux;          // number of Linux line endings, LF
-    std::int32_t eolMacOld;         // number of old Mac line endings. CR
+    std::size_t eolWindows;         // number of Windows line endings, CRLF
+    std::size_t eolLinux;           // number of Linux line endings, LF
+    std::size_t eolMacOld;          // number of old Mac line endings. CR
     char outputEOL[4];     // next output end of line char
     std::streamoff peekStart;   // starting position for peekNextLine
     bool prevLineDeleted;  // the previous input line was deleted
@@ -127,15 +139,77 @@ namespace astyle
     }
   };
 
+//----------------------------------------------------------------------------
+// ASLineDiff class for the line differences between two texts
+// used by both console and library builds
+// The lines are compared with the Myers difference algorithm. The lines
+// refer to the texts, which must not be changed while the object is used.
+//----------------------------------------------------------------------------
+
+  class ASLineEdit
+  {
+  public:
+    std::size_t origLine;       // first deleted line, or the insert position, in the original text
+    std::size_t deleteCount;    // number of original lines deleted
+    std::size_t newLine;        // first inserted line in the new text
+    std::size_t insertCount;    // number of new lines inserted
+  };
+
+  class ASLineDiff
+  {
+  public:
+    ASLineDiff(std::string_view origText, std::string_view newText, bool splitAtCR = false);
+    const std::vector<ASLineEdit>& getEdits() const;
+    const std::vector<std::string_view>& getNewLines() const;
+    const std::vector<std::string_view>& getOrigLines() const;
+    void writeEditList(std::string& editsOut) const;
+    void writeUnifiedDiff(std::string& diffOut, const std::string& origName,
+                          const std::string& newName, std::size_t contextLines) const;
+
+  private:
+    ASLineDiff(const ASLineDiff& copy);         // copy constructor not to be implemented
+    ASLineDiff& operator=(ASLineDiff&);         // assignment operator not to be implemented
+    void appendLine(std::string& diffOut, char prefix, std::string_view line) const;
+    void buildEdits();
+    void compareLines(std::ptrdiff_t xOff, std::ptrdiff_t xLim, std::ptrdiff_t yOff, std::ptrdiff_t yLim);
+    void findMiddleSnake(std::ptrdiff_t xOff, std::ptrdiff_t xLim, std::ptrdiff_t yOff, std::ptrdiff_t yLim,
+                         std::ptrdiff_t& xMid, std::ptrdiff_t& yMid);
+    void splitLines(std::string_view text, std::vector<std::string_view>& lines) const;
+
+    std::vector<std::string_view> origLines;    // lines of the original text including the line ends
+    std::vector<std::string_view> newLines;     // lines of the new text including the line ends
+    std::vector<std::size_t> origIds;           // ids of the compared original lines, equal lines have the same id
+    std::vector<std::size_t> newIds;            // ids of the compared new lines, equal lines have the same id
+    std::vector<std::size_t> origIndex;         // original line of each compared original line
+    std::vector<std::size_t> newIndex;          // new line of each compared new line
+    std::vector<bool> origChanged;              // the original line is deleted
+    std::vector<bool> newChanged;               // the new line is inserted
+    std::vector<std::ptrdiff_t> forwardX;       // furthest forward x on each diagonal
+    std::vector<std::ptrdiff_t> backwardX;      // furthest backward x on each diagonal
+    std::ptrdiff_t diagonalOffset;              // index of diagonal zero in the diagonal vectors
+    std::size_t tooExpensive;                   // edit cost to stop searching for a minimal diff
+    bool isCRLineEnd;                           // a CR not followed by LF also ends a line
+    std::vector<ASLineEdit> edits;              // the edits in line order
+  };
+
 //----------------------------------------------------------------------------
 // ASOptions class for options processing
 // used by both console and library builds
 //----------------------------------------------------------------------------
 
+#ifndef ASTYLE_LIB
+  class ASConsole;
+#endif
+
   class ASOptions
   {
   public:
+#ifdef ASTYLE_LIB
     ASOptions(ASFormatter& formatterArg) : formatter(formatterArg) {}
+#else
+    ASOptions(ASFormatter& formatterArg, ASConsole& consoleArg)
+      : formatter(formatterArg), console(consoleArg) {}
+#endif
     std::string getOptionErrors();
     void importOptions(std::istream& in, std::vector<std::string> &optionsVector);
     bool parseOptions(std::vector<std::string> &optionsVector, const std::string& errorInfo);
@@ -143,6 +217,9 @@ namespace astyle
   private:
     // variables
     ASFormatter& formatter;      // reference to the ASFormatter object
+#ifndef ASTYLE_LIB
+    ASConsole& console;          // reference to the ASConsole object for console options
+#endif
     std::stringstream optionErrors;    // option error messages
 
     // functions
@@ -157,8 +234,173 @@ namespace astyle
     void parseOption(const std::string& arg, const std::string& errorInfo);
   };
 
+#ifdef ASTYLE_LIB
+
+//----------------------------------------------------------------------------
+// ASMemoryStreamBuf class for library build
+// A read only stream buffer for a text in memory.
+// The text is read in place instead of being copied to a string stream.
+//----------------------------------------------------------------------------
+
+  class ASMemoryStreamBuf : public std::streambuf
+  {
+  public:
+    ASMemoryStreamBuf(const char* data, std::size_t dataSize);
+
+  protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+  };
+
+//----------------------------------------------------------------------------
+// ASLibFormatter class for library build
+// A formatter with options that are parsed once.
+// It may be kept by the caller and reused to format many source texts.
+//----------------------------------------------------------------------------
+
+  class ASLibFormatter
+  {
+  public:
+    ASLibFormatter() {}
+    bool formatText(const char* textIn, std::size_t textSizeIn, fpError fpErrorHandler);
+    void getTextEdits(const char* textIn, std::size_t textSizeIn, std::string& editsOut) const;
+    const std::string& getTextOut() const;
+    bool setOptions(const char* pOptions, fpError fpErrorHandler);
+
+  private:
+    ASLibFormatter(const ASLibFormatter& copy);       // copy constructor not to be implemented
+    ASLibFormatter& operator=(ASLibFormatter&);       // assignment operator not to be implemented
+    ASFormatter formatter;      // the formatter with the options set
+    std::string textOut;        // the formatted text, its capacity is reused
+  };
+
+#endif  // ASTYLE_LIB
+
 #ifndef  ASTYLE_LIB
 
+//----------------------------------------------------------------------------
+// ASFileBuffer class for console build
+// Holds a file as it passes through the read, format, and write stages
+// of the file pipeline. The buffers are reused for the following files.
+//----------------------------------------------------------------------------
+
+  class ASFileBuffer
+  {
+  public:
+    std::string fileName;         // path and name of the file
+    std::stringstream in;         // input file text
+    std::ostringstream out;       // formatted file text
+    FileEncoding encoding;        // encoding of the input file
+    char pendingEOL;              // line end char not yet counted
+    std::size_t eolWindows;       // number of input windows line ends
+    std::size_t eolLinux;         // number of input linux line ends
+    std::size_t eolMacOld;        // number of input macold line ends
+    bool isChanged;               // the formatted file must be written
+    bool isVerified;              // the formatted text matches the input checksum
+    bool isStreamed;              // a large file formatted from the disk instead of the buffer
+    bool isTempFileRenamed;       // the temporary file replaces the streamed file by a rename
+    std::string tempFileName;     // temporary file with the formatted text of a streamed file
+    std::string errorMessage;     // a read or write error, reported by the main thread
+    std::string errorFileName;    // the file name for the error message
+
+    ASFileBuffer()
+    {
+      clear();
+    }
+
+    void clear();
+  };
+
+//----------------------------------------------------------------------------
+// ASFileQueue class for console build
+// A bounded queue of file buffers between two stages of the file pipeline.
+// push() waits when the queue is full and pop() waits when it is empty.
+//----------------------------------------------------------------------------
+
+  class ASFileQueue
+  {
+  public:
+    ASFileQueue(std::size_t queueDepth)
+    {
+      depth = queueDepth;
+      isClosed = false;
+      occupancySum = 0;
+      pushCount = 0;
+    }
+
+    void close();
+    std::size_t getOccupancySum() const;
+    std::size_t getPushCount() const;
+    bool pop(ASFileBuffer*& buffer);
+    void push(ASFileBuffer* buffer);
+
+  private:
+    std::mutex queueMutex;              // protects the queue variables
+    std::condition_variable notEmpty;   // signaled when a buffer is pushed or the queue is closed
+    std::condition_variable notFull;    // signaled when a buffer is popped
+    std::deque<ASFileBuffer*> queue;    // the buffers waiting for the next stage
+    std::size_t depth;                  // maximum number of buffers in the queue
+    bool isClosed;                      // no more buffers will be pushed
+    std::size_t occupancySum;           // sum of the buffers waiting at each push
+    std::size_t pushCount;              // number of buffers pushed
+  };
+
+//----------------------------------------------------------------------------
+// ASJsonValue class for console build
+// A JSON value read from a language server message.
+// An object keeps its member names and values in two parallel vectors.
+//----------------------------------------------------------------------------
+
+  class ASJsonValue
+  {
+  public:
+    enum JsonType { JSON_NULL, JSON_BOOLEAN, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+    ASJsonValue()
+    {
+      type = JSON_NULL;
+    }
+
+    const std::vector<ASJsonValue>& getElements() const;
+    std::int64_t getInteger() const;
+    std::string getJson() const;
+    const ASJsonValue& getMember(const std::string& name) const;
+    const std::string& getString() const;
+    bool isNull() const;
+    bool parse(const std::string& jsonText);
+    static std::string quote(const std::string& text);
+
+  private:
+    bool parseCodeUnit(const std::string& jsonText, std::size_t& pos, std::uint32_t& codeUnit) const;
+    bool parseString(const std::string& jsonText, std::size_t& pos, std::string& value) const;
+    bool parseValue(const std::string& jsonText, std::size_t& pos, std::size_t depth);
+    void skipSpace(const std::string& jsonText, std::size_t& pos) const;
+
+    JsonType type;                          // type of the value
+    std::string text;                       // string value, or the text of a number or boolean
+    std::vector<std::string> memberNames;   // member names of an object
+    std::vector<ASJsonValue> elements;      // array elements, or the member values of an object
+  };
+
+//----------------------------------------------------------------------------
+// ASLspDocument class for console build
+// A text document opened by a language client.
+// The formatted text is kept until the document is changed.
+//----------------------------------------------------------------------------
+
+  class ASLspDocument
+  {
+  public:
+    std::string text;                   // current text of the document
+    std::string formattedText;          // formatted text, valid when isFormatted is set
+    bool isFormatted;                   // the formatted text is for the current text
+
+    ASLspDocument()
+    {
+      isFormatted = false;
+    }
+  };
+
 //----------------------------------------------------------------------------
 // ASConsole class for console build
 //----------------------------------------------------------------------------
@@ -168,28 +410,39 @@ namespace astyle
   private:  // variables
     ASFormatter& formatter;        // reference to the ASFormatter object
     ASLocalizer localizer;        // ASLocalizer object
+    std::ostream* errorStream;    // direct error messages to cerr or cout
     // command line options
     bool isRecursive;                   // recursive option
     std::string origSuffix;                  // suffix= option
     bool noBackup;                      // suffix=none option
     bool preserveDate;                  // preserve-date option
     bool isVerbose;                     // verbose option
+    bool isDiff;                        // diff option
+    bool isLsp;                         // lsp option
+    bool isTar;                         // tar option
+    bool isWatch;                       // watch option
     bool isQuiet;                       // quiet option
     bool isFormattedOnly;               // formatted lines only option
     bool ignoreExcludeErrors;           // don't abort on unmatched excludes
     bool ignoreExcludeErrorsDisplay;    // don't display unmatched excludes
     bool optionsFileRequired;           // options= option
     bool useAscii;                      // ascii option
+    std::string filesFrom;                   // files-from= option
+    std::string changedSince;                // changed-since= option
     // other variables
     bool hasWildcard;                   // file name includes a wildcard
     std::size_t mainDirectoryLength;         // directory length to be excluded in displays
     bool filesAreIdentical;        // input and output files are identical
-    bool lineEndsMixed;          // output has mixed line ends
-    std::int32_t  linesOut;                      // number of output lines
-    std::int32_t  filesFormatted;                // number of files formatted
-    std::int32_t  filesUnchanged;                // number of files unchanged
-    char outputEOL[4];          // current line end
-    char prevEOL[4];          // previous line end
+    bool lineEndsMixed;          // input has mixed line ends
+    std::size_t linesOut;                        // number of output lines
+    std::size_t filesFormatted;                  // number of files formatted
+    std::size_t filesUnchanged;                  // number of files unchanged
+    std::size_t filesNotVerified;                // number of files not changed because the output did not match
+    char outputEOL[4];          // output line end
+    std::size_t readOccupancy;          // sum of the read queue occupancy
+    std::size_t writeOccupancy;         // sum of the write queue occupancy
+    std::size_t pipelineFiles;          // number of files in the file pipeline
+    std::atomic<bool> isPipelineStopped;    // a file error stops the file pipeline
 
     std::string optionsFileName;             // file path and name of the options file to use
     std::string targetDirectory;             // path to the directory being processed
@@ -205,12 +458,17 @@ namespace astyle
   public:
     ASConsole(ASFormatter& formatterArg) : formatter(formatterArg)
     {
+      errorStream = &std::cerr;
       // command line options
       isRecursive = false;
       origSuffix = ".orig";
       noBackup = false;
       preserveDate = false;
       isVerbose = false;
+      isDiff = false;
+      isLsp = false;
+      isTar = false;
+      isWatch = false;
       isQuiet = false;
       isFormattedOnly = false;
       ignoreExcludeErrors = false;
@@ -222,50 +480,65 @@ namespace astyle
       filesAreIdentical = true;
       lineEndsMixed = false;
       outputEOL[0] = '\0';
-      prevEOL[0] = '\0';
+      readOccupancy = 0;
+      writeOccupancy = 0;
+      pipelineFiles = 0;
+      isPipelineStopped = false;
       mainDirectoryLength = 0;
       filesFormatted = 0;
       filesUnchanged = 0;
+      filesNotVerified = 0;
       linesOut = 0;
     }
 
     // functions
-    void convertLineEnds(std::ostringstream& out, std::int32_t lineEnd);
     FileEncoding detectEncoding(const char* data, std::size_t dataSize) const;
     void error() const;
     void error(const char* why, const char* what) const;
     void formatCinToCout() const;
     std::vector<std::string> getArgvOptions(std::int32_t argc, char** argv) const;
+    bool fileListIsEmpty();
     bool fileNameVectorIsEmpty();
-    std::int32_t  getFilesFormatted();
-    std::int32_t  getFilesUnchanged();
+    std::size_t getFilesFormatted();
+    std::size_t getFilesNotVerified();
+    std::size_t getFilesUnchanged();
     bool getIgnoreExcludeErrors();
     bool getIgnoreExcludeErrorsDisplay();
     bool getIsFormattedOnly();
+    bool getIsLsp();
     bool getIsQuiet();
     bool getIsRecursive();
     bool getIsVerbose();
     bool getLineEndsMixed();
     bool getNoBackup();
     std::string getLanguageID() const;
-    std::string getNumberFormat(std::int32_t num, std::size_t = 0) const ;
-    std::string getNumberFormat(std::int32_t num, const char* groupingArg, const char* separator) const;
+    std::string getNumberFormat(std::size_t num, std::size_t = 0) const ;
+    std::string getNumberFormat(std::size_t num, const char* groupingArg, const char* separator) const;
     std::string getOptionsFileName();
     bool getOptionsFileRequired();
     std::string getOrigSuffix();
     bool getPreserveDate();
     void processFiles();
+    bool runLanguageServer();
     void processOptions(std::vector<std::string>& argvOptions);
+    void setChangedSince(std::string revision);
+    void setErrorStream(std::ostream* stream);
+    void setFilesFrom(std::string listName);
     void setIgnoreExcludeErrors(bool state);
     void setIgnoreExcludeErrorsAndDisplay(bool state);
+    void setIsDiff(bool state);
     void setIsFormattedOnly(bool state);
+    void setIsLsp(bool state);
     void setIsQuiet(bool state);
     void setIsRecursive(bool state);
+    void setIsTar(bool state);
     void setIsVerbose(bool state);
+    void setIsWatch(bool state);
     void setNoBackup(bool state);
     void setOptionsFileName(std::string name);
     void setOptionsFileRequired(bool state);
     void setOrigSuffix(std::string suffix);
+    void setOutputBuffering() const;
     void setPreserveDate(bool state);
     void setProgramLocale();
     void standardizePath(std::string& path, bool removeBeginningSeparator = false) const;
@@ -287,32 +560,80 @@ namespace astyle
 
   private:
     ASConsole& operator=(ASConsole&);          // not to be implemented
-    void correctMixedLineEnds(std::ostringstream& out);
+    void appendInput(ASFileBuffer& buffer, char* data, std::size_t dataSize, bool firstBlock) const;
+    void copyTarData(std::uint64_t size, std::vector<char>& copyBuffer) const;
+    void applyLspChanges(ASLspDocument& document, const ASJsonValue& contentChanges) const;
+    void checkFileError(const ASFileBuffer& buffer) const;
+    void countLineEnds(const char* data, std::size_t dataSize, ASFileBuffer& buffer) const;
+    std::string createCopyTempFile(const std::string& fileName_) const;
+    std::string createTempFile(const std::string& fileName_) const;
+    void fileError(ASFileBuffer& buffer, const char* why, const char* what) const;
+    void formatBuffer(ASFileBuffer& buffer);
     void formatFile(const std::string& fileName_);
+    void formatFilesPipelined();
+    void formatFileList(FILE* fileList);
+    template<typename T>
+    void formatLines(ASStreamIterator<T>& streamIterator, std::ostream& out,
+                     LineEndFormat lineEndFormat, ASFileBuffer& buffer);
+    void formatListPath(std::string& listPath);
+    void formatChangedFiles();
+    void formatTarMember(char* header, std::vector<char>& memberData, std::size_t dataSize, ASFileBuffer& buffer);
+    void formatStreamedFile(ASFileBuffer& buffer, LineEndFormat lineEndFormat);
+    void formatTarStream();
     std::string getCurrentDirectory(const std::string& fileName_) const;
     void getFileNames(const std::string& directory, const std::string& wildcard);
     void getFilePaths(std::string& filePath);
+    bool getLspEdits(const std::string& uri, ASLspDocument& document,
+                     std::size_t firstLine, std::size_t lastLine, std::string& edits);
+    std::size_t getLspOffset(const std::string& text, const ASJsonValue& position) const;
+    std::string getLspPosition(std::size_t line, std::size_t character) const;
+    std::string getOutputData(FileEncoding encoding, const std::string& text) const;
+    const char* getOutputEOL(LineEndFormat lineEndFormat, const char* currentEOL);
     std::string getParam(const std::string& arg, const char* op);
-    void initializeOutputEOL(LineEndFormat lineEndFormat);
+    std::uint32_t getTarChecksum(const char* header) const;
+    std::uint64_t getTarNumber(const char* field, std::size_t fieldSize) const;
+    void initializeOutputEOL(LineEndFormat lineEndFormat, const ASFileBuffer& buffer);
     bool isOption(const std::string& arg, const char* op);
     bool isOption(const std::string& arg, const char* op1, const char* op2);
     bool isParamOption(const std::string& arg, const char* option);
+    bool isFilePathExcluded(const std::string& filePath);
     bool isPathExclued(const std::string& subPath);
+    bool isSingleFilePath(const std::string& filePath) const;
+    bool isWatchedFile(const std::vector<std::string>& watchBase,
+                       const std::vector<std::string>& watchWildcard,
+                       const std::string& directory, const char* name);
+    bool isTarMemberSelected(const std::string& memberName);
+    bool linkFile(const char* oldFileName, const char* newFileName) const;
+    std::string quoteCommandArg(const std::string& arg) const;
+    void parsePaxHeader(const std::string& paxData, std::string& paxPath,
+                        std::uint64_t& paxSize, bool& paxHasSize) const;
+    void prefetchFile(const std::string& fileName_) const;
     void printHelp() const;
     void printMsg(const char* msg, const std::string& data) const;
     void printSeparatingLine() const;
     void printVerboseHeader() const;
     void printVerboseStats(clock_t startTime) const;
-    FileEncoding readFile(const std::string& fileName, std::stringstream& in) const;
-    void removeFile(const char* fileName_, const char* errMsg) const;
-    void renameFile(const char* oldFileName, const char* newFileName, const char* errMsg) const;
-    void setOutputEOL(LineEndFormat lineEndFormat, const char* currentEOL);
-    void sleep(std::int32_t seconds) const;
+    void readFile(ASFileBuffer& buffer) const;
+    bool readLspMessage(std::string& message) const;
+    void readFiles(ASFileQueue& freeQueue, ASFileQueue& readQueue);
+    void readTarData(std::vector<char>& memberData, std::uint64_t size) const;
+    bool removeFile(ASFileBuffer& buffer, const char* fileName_, const char* errMsg) const;
+    bool renameFile(ASFileBuffer& buffer, const char* oldFileName, const char* newFileName,
+                    const char* errMsg) const;
+    void setTarNumber(char* field, std::size_t fieldSize, std::uint64_t value) const;
+    void sleep(std::int32_t milliseconds) const;
     std::int32_t  swap8to16bit(std::int32_t value) const;
     std::int32_t  swap16bit(std::int32_t value) const;
     std::int32_t  waitForRemove(const char* oldFileName) const;
     std::int32_t  wildcmp(const char* wild, const char* data) const;
-    void writeFile(const std::string& fileName_, FileEncoding encoding, std::ostringstream& out) const;
+    void watchFiles();
+    void writeBuffer(ASFileBuffer& buffer);
+    bool writeDiff(const ASFileBuffer& buffer) const;
+    void writeFile(ASFileBuffer& buffer) const;
+    void writeFiles(ASFileQueue& writeQueue, ASFileQueue& freeQueue, ASFileBuffer*& failedBuffer);
+    void writeStreamedFile(ASFileBuffer& buffer) const;
+    void writeLspMessage(const std::string& message) const;
+    void writeTarData(const char* data, std::size_t dataSize) const;
 #ifdef _WIN32
     void displayLastError();
 #endif
@@ -329,12 +650,26 @@ namespace astyle
 #ifdef ASTYLE_JNI
 void  STDCALL javaErrorHandler(std::int32_t errorNumber, const char* errorMessage);
 char* STDCALL javaMemoryAlloc(unsigned long memoryNeeded);
+jint  copyJavaTextOut(JNIEnv* env, const astyle::ASLibFormatter* formatter, jobject textOutBuffer);
+bool  setJavaErrorHandler(JNIEnv* env, jobject obj);
 // the following function names are constructed from method names in the calling java program
 extern "C"  EXPORT
 jstring STDCALL Java_AStyleInterface_AStyleGetVersion(JNIEnv* env, jclass);
 extern "C"  EXPORT
 jstring STDCALL Java_AStyleInterface_AStyleMain
 (JNIEnv* env, jobject obj, jstring textInJava, jstring optionsJava);
+extern "C"  EXPORT
+jlong STDCALL Java_AStyleInterface_AStyleCreateFormatter
+(JNIEnv* env, jobject obj, jstring optionsJava);
+extern "C"  EXPORT
+void STDCALL Java_AStyleInterface_AStyleDeleteFormatter
+(JNIEnv* env, jobject obj, jlong formatterHandle);
+extern "C"  EXPORT
+jint STDCALL Java_AStyleInterface_AStyleFormatBuffer
+(JNIEnv* env, jobject obj, jlong formatterHandle, jobject textInBuffer, jint textInLength, jobject textOutBuffer);
+extern "C"  EXPORT
+jint STDCALL Java_AStyleInterface_AStyleGetFormattedText
+(JNIEnv* env, jobject obj, jlong formatterHandle, jobject textOutBuffer);
 #endif //  ASTYLE_JNI
 
 